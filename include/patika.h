@@ -15,7 +15,9 @@
 #include "patika/commands/barrack.h"
 #include "patika/commands/guard.h"
 #include "patika/events.h"
+#include "patika/records.h"
 #include "patika/snapshot.h"
+#include "patika/stream.h"
 #include "patika/api.h"
 #include "patika/patika_log.h"
 
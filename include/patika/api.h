@@ -9,7 +9,9 @@
 #include "commands/base.h"
 #include "commands/guard.h"
 #include "events.h"
+#include "records.h"
 #include "snapshot.h"
+#include "stream.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,17 +21,140 @@ extern "C" {
     PATIKA_API void patika_destroy(PatikaHandle handle);
 
 
+    /**
+     * @brief Allocate a command payload from the calling thread's slab
+     * @details Set PATIKA_COMMAND_FLAG_POOLED_PAYLOAD on the command carrying
+     *          it; the simulation thread hands the block back to the slab
+     *          after processing, without going through the global allocator.
+     * @return NULL on allocation failure
+     */
+    PATIKA_API void *patika_alloc_payload(PatikaHandle handle, size_t size);
+
+    /**
+     * @brief Return a payload that was never submitted (e.g. queue was full)
+     */
+    PATIKA_API void patika_free_payload(PatikaHandle handle, void *payload);
+
     PATIKA_API PatikaError patika_submit_command(
         PatikaHandle handle,
         const PatikaCommand *cmd
     );
 
+    /** @brief Timeout for patika_submit_command_wait that never expires */
+    #define PATIKA_WAIT_FOREVER 0xFFFFFFFFu
+
+    /**
+     * @brief Submit a command, parking the caller while the queue is full
+     * @details The simulation thread wakes parked producers once a tick has
+     *          drained the queue.
+     * @param timeout_ms Longest time to wait, or PATIKA_WAIT_FOREVER
+     * @return PATIKA_OK, or PATIKA_ERR_TIMEOUT if no slot freed up in time
+     */
+    PATIKA_API PatikaError patika_submit_command_wait(
+        PatikaHandle handle,
+        const PatikaCommand *cmd,
+        uint32_t timeout_ms
+    );
+
+    /**
+     * @brief Submit a command that runs at the start of a later tick
+     * @details Ticks are numbered by PatikaStats.total_ticks before the tick
+     *          runs, so execute_at_tick = total_ticks + N fires N ticks from
+     *          now. A tick that has already started runs the command right
+     *          after the batch it was dequeued in, outside that batch's
+     *          coalescing and phase sort. Commands due on the same tick fire in the
+     *          order they were scheduled, ahead of that tick's queue.
+     * @return PATIKA_OK, PATIKA_ERR_QUEUE_FULL or PATIKA_ERR_CAPACITY
+     */
+    PATIKA_API PatikaError patika_schedule_command(
+        PatikaHandle handle,
+        const PatikaCommand *cmd,
+        uint64_t execute_at_tick
+    );
+
+    /**
+     * @brief Validate and enqueue a binary command stream (see stream.h)
+     * @details The buffer is only read during the call. Every record is
+     *          decoded straight into a reserved queue slot, all-or-nothing.
+     * @return PATIKA_OK, PATIKA_ERR_BAD_STREAM, PATIKA_ERR_INVALID_COMMAND_TYPE
+     *         (record type without an encoding) or PATIKA_ERR_QUEUE_FULL
+     */
+    PATIKA_API PatikaError patika_submit_stream(
+        PatikaHandle handle,
+        const void *bytes,
+        size_t len
+    );
+
+    /**
+     * @brief Submit commands all-or-nothing
+     * @return PATIKA_OK if all were queued, PATIKA_ERR_QUEUE_FULL if none were
+     */
     PATIKA_API PatikaError patika_submit_commands(
         PatikaHandle handle,
         const PatikaCommand *cmds,
         uint32_t count
     );
 
+    /**
+     * @brief Submit commands with one queue reservation per contiguous run
+     * @details Commands are copied into reserved slots and published together,
+     *          in order. Partial mode accepts the longest prefix that fits.
+     * @return Number of commands accepted (a prefix of cmds)
+     */
+    PATIKA_API uint32_t patika_submit_batch(
+        PatikaHandle handle,
+        const PatikaCommand *cmds,
+        uint32_t count,
+        PatikaSubmitMode mode
+    );
+
+    /**
+     * @brief Claim a private command lane for the calling producer
+     * @details Requires config.max_producer_lanes > 0. A lane has a single
+     *          producer: use the token from one thread at a time. Lanes are
+     *          drained after the shared queue, in token order.
+     * @return PATIKA_INVALID_PRODUCER_TOKEN when all lanes are taken
+     */
+    PATIKA_API PatikaProducerToken patika_register_producer(PatikaHandle handle);
+
+    PATIKA_API PatikaError patika_lane_submit(
+        PatikaHandle handle,
+        PatikaProducerToken token,
+        const PatikaCommand *cmd
+    );
+
+    /**
+     * @brief Submit commands to a producer lane
+     * @return Number of commands accepted (a prefix of cmds)
+     */
+    PATIKA_API uint32_t patika_lane_submit_batch(
+        PatikaHandle handle,
+        PatikaProducerToken token,
+        const PatikaCommand *cmds,
+        uint32_t count,
+        PatikaSubmitMode mode
+    );
+
+    PATIKA_API PatikaError patika_get_lane_stats(
+        PatikaHandle handle,
+        PatikaProducerToken token,
+        PatikaLaneStats *out
+    );
+
+    /**
+     * @brief Re-run a journal recorded with config.journal_path, at full speed
+     * @details Ticks the handle once per recorded tick, feeding each tick the
+     *          commands it executed when recorded. Start from a fresh context
+     *          created with the recording's config for an identical run.
+     * @param out_ticks Optional, receives the number of ticks replayed
+     * @return PATIKA_OK, PATIKA_ERR_IO or PATIKA_ERR_BAD_STREAM
+     */
+    PATIKA_API PatikaError patika_replay(
+        PatikaHandle handle,
+        const char *path,
+        uint64_t *out_ticks
+    );
+
 
     PATIKA_API void patika_tick(PatikaHandle handle);
 
@@ -39,10 +164,158 @@ extern "C" {
         uint32_t max_events
     );
 
+    /**
+     * @brief Park the calling consumer until the event queue has events
+     * @details Returns at once if events are already queued. The simulation
+     *          signals at most once per tick, at its end, and only consumers
+     *          that found the queue empty (here, or by polling it dry).
+     * @param timeout_ms Longest time to wait, or PATIKA_WAIT_FOREVER
+     * @return PATIKA_OK or PATIKA_ERR_TIMEOUT
+     */
+    PATIKA_API PatikaError patika_wait_events(PatikaHandle handle, uint32_t timeout_ms);
 
+    /**
+     * @brief eventfd that becomes readable under the same rule as patika_wait_events
+     * @details Requires config.event_notify_fd. For epoll loops: on readiness,
+     *          read the descriptor to reset it, then poll until no events are
+     *          returned. The context owns and closes it.
+     * @return -1 when not enabled or not supported on this platform
+     */
+    PATIKA_API int patika_get_event_fd(PatikaHandle handle);
+
+    /**
+     * @brief Read pending events in place, without copying them out
+     * @details The spans point into the event queue and stay valid until
+     *          patika_commit_events. Call both from the polling thread.
+     * @return Events in both spans, at most max_events
+     */
+    PATIKA_API uint32_t patika_peek_events(
+        PatikaHandle handle,
+        uint32_t max_events,
+        PatikaEventSpan *out
+    );
+
+    /**
+     * @brief Release the first count peeked events back to the simulation
+     * @details count is clamped to the events currently readable.
+     */
+    PATIKA_API void patika_commit_events(PatikaHandle handle, uint32_t count);
+
+    /**
+     * @brief Copy pending typed event records out as one packed block
+     * @details Requires config.event_record_ring_size. Only whole records are
+     *          copied, oldest first; walk them with patika_record_next. out
+     *          must be 8-byte aligned. The record ring sees every event,
+     *          event filters do not apply to it.
+     * @return Bytes written, 0 when nothing is pending or the next record
+     *         does not fit in capacity
+     */
+    PATIKA_API uint32_t patika_poll_event_records(
+        PatikaHandle handle,
+        void *out,
+        uint32_t capacity
+    );
+
+    /**
+     * @brief Open a broadcast cursor, starting at the next event emitted
+     * @details Requires config.max_event_subscribers > 0. Every subscriber
+     *          sees every event, reading the ring in place. Use a cursor from
+     *          one thread at a time.
+     * @return PATIKA_INVALID_EVENT_CURSOR when all cursors are taken
+     */
+    PATIKA_API PatikaEventCursor patika_subscribe_events(PatikaHandle handle);
+
+    PATIKA_API void patika_unsubscribe_events(
+        PatikaHandle handle,
+        PatikaEventCursor cursor
+    );
+
+    /**
+     * @brief Read a subscriber's pending events in place
+     * @details Spans stay readable until patika_cursor_commit_events. A
+     *          subscriber overrun by a full ring skips to the oldest event
+     *          left; under PATIKA_OVERFLOW_LAG the peek then returns
+     *          PATIKA_ERR_LAGGED with empty spans, and the next one resumes.
+     * @return PATIKA_OK, PATIKA_ERR_LAGGED or PATIKA_ERR_INVALID_ID
+     */
+    PATIKA_API PatikaError patika_cursor_peek_events(
+        PatikaHandle handle,
+        PatikaEventCursor cursor,
+        uint32_t max_events,
+        PatikaEventSpan *out
+    );
+
+    /**
+     * @brief Advance a cursor past the first count peeked events
+     * @return PATIKA_OK, or PATIKA_ERR_LAGGED if the simulation overwrote
+     *         some of them while they were being read (counted as dropped)
+     */
+    PATIKA_API PatikaError patika_cursor_commit_events(
+        PatikaHandle handle,
+        PatikaEventCursor cursor,
+        uint32_t count
+    );
+
+    /**
+     * @brief Limit which events enter the event queue, NULL accepts all (the default)
+     * @details Takes effect from the next event emitted.
+     */
+    PATIKA_API void patika_set_event_filter(
+        PatikaHandle handle,
+        const PatikaEventFilter *filter
+    );
+
+    /**
+     * @brief Limit which events a subscriber wants, NULL accepts all (the default)
+     * @details The broadcast ring is shared: it holds an event when any
+     *          subscriber's filter accepts it, and every subscriber reads all
+     *          events it holds. Filters keep unwanted events out of the ring;
+     *          they do not give a subscriber a private view.
+     */
+    PATIKA_API PatikaError patika_set_cursor_filter(
+        PatikaHandle handle,
+        PatikaEventCursor cursor,
+        const PatikaEventFilter *filter
+    );
+
+    PATIKA_API PatikaError patika_get_cursor_stats(
+        PatikaHandle handle,
+        PatikaEventCursor cursor,
+        PatikaCursorStats *out
+    );
+
+
+    /**
+     * @brief Latest snapshot, unpinned
+     * @details It stays intact at least until the next tick completes;
+     *          slower readers should use patika_acquire_snapshot.
+     */
     PATIKA_API const PatikaSnapshot *patika_get_snapshot(PatikaHandle handle);
+
+    /**
+     * @brief Pin the latest snapshot until patika_release_snapshot
+     * @details The simulation never waits for a pinned snapshot and never
+     *          writes into one; when readers pin every spare buffer it skips
+     *          the snapshot update (PatikaStats.snapshots_skipped) and keeps
+     *          publishing the one before. Safe from any thread.
+     */
+    PATIKA_API const PatikaSnapshot *patika_acquire_snapshot(PatikaHandle handle);
+
+    PATIKA_API void patika_release_snapshot(
+        PatikaHandle handle,
+        const PatikaSnapshot *snapshot
+    );
     PATIKA_API PatikaStats patika_get_stats(PatikaHandle handle);
 
+    /**
+     * @brief Agent moves of the last completed tick as one packed block
+     * @details Requires config.movement_deltas. Double-buffered like the
+     *          snapshot: read it before the next tick completes, and check
+     *          tick to notice a skipped one.
+     * @return NULL when not enabled
+     */
+    PATIKA_API const PatikaMovementDeltas *patika_get_movement_deltas(PatikaHandle handle);
+
     // it still pushes command to queue (use payloads instead)
 //    PATIKA_API PatikaError patika_add_agent_sync(
 //        PatikaHandle handle,
@@ -70,4 +70,15 @@ typedef struct {
     AgentID *out_agent_id;
 } AddAgentWithBehaviorPayload;
 
+/**
+ * @brief One agent of a CMD_ADD_AGENTS_BULK wave
+ */
+typedef struct PatikaSpawnRecord {
+    int32_t start_q, start_r;
+    uint8_t faction;
+    uint8_t side;
+    BuildingID parent_barrack;
+    PatikaCollisionData collision_data;
+} PatikaSpawnRecord;
+
 #endif
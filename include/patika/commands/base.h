@@ -3,10 +3,14 @@
 
 #include "../types.h"
 #include "../enums.h"
+#include "agent.h"
 
 // inline command size threshold (32 bytes)
 #define PATIKA_INLINE_COMMAND_SIZE 32
 
+/** Payload came from patika_alloc_payload, the sim thread returns it to its slab */
+#define PATIKA_COMMAND_FLAG_POOLED_PAYLOAD (1u << 0)
+
 /**
  * @brief Base command structure
  * @details Commands ≤32 bytes use inline storage, larger ones use payload pointer
@@ -14,6 +18,7 @@
 typedef struct PatikaCommand
 {
     CommandType type;
+    uint32_t flags; /**< PATIKA_COMMAND_FLAG_*, zero-initialise commands */
 
     union {
         uint8_t inline_data[PATIKA_INLINE_COMMAND_SIZE];
@@ -55,6 +60,17 @@ typedef struct PatikaCommand
             BuildingID barrack_id;
         } clear_barrack_guard_tiles;
 
+        /* CMD_ADD_AGENTS_BULK: arrays are caller-owned and must stay valid
+         * until the tick that processes the command; outputs are optional.
+         * With PATIKA_COMMAND_FLAG_POOLED_PAYLOAD the records array came from
+         * patika_alloc_payload and is released after processing. */
+        struct {
+            const PatikaSpawnRecord *records;
+            AgentID *out_agent_ids;   /**< count IDs, PATIKA_INVALID_AGENT_ID on failure */
+            PatikaError *out_results; /**< count per-record result codes */
+            uint32_t count;
+        } add_agents_bulk;
+
         struct {
             void *payload;
         } large_command;
@@ -20,8 +20,39 @@ extern "C" {
         uint32_t grid_height;        /**< Map height in cells (r axis) */
         uint32_t sector_size;        /**< Optional sector side length */
         uint32_t command_queue_size; /**< MPSC command queue capacity */
-        uint32_t event_queue_size;   /**< SPSC event queue capacity */
+        uint32_t event_queue_size;   /**< SPSC event queue capacity, 0 leaves events to
+                                          broadcast subscribers only */
         uint64_t rng_seed;           /**< RNG seed */
+        uint32_t max_producer_lanes; /**< Per-producer command lanes, 0 disables */
+        uint32_t lane_queue_size;    /**< Capacity of each lane, 0 uses command_queue_size */
+        uint8_t coalesce_commands;   /**< Non-zero drops redundant goal/tile/remove commands per tick */
+        uint8_t sort_commands;       /**< Non-zero processes each tick as map edits, removes,
+                                          barracks, spawns, agent control, in submission
+                                          order within each group (per chunk under
+                                          command_budget_us) */
+        uint32_t max_commands_per_tick; /**< Queued commands processed per tick, 0 = one
+                                             full queue; the rest waits for later ticks.
+                                             Split fairly between the shared queue and
+                                             each lane when more is pending */
+        uint32_t command_budget_us;  /**< Time allowed for queued commands per tick, 0 = no
+                                          limit; checked every few hundred commands, each
+                                          chunk coalesced and sorted on its own */
+        uint8_t event_notify_fd;     /**< Non-zero creates an eventfd (Linux) signalled
+                                          with the event queue, see patika_get_event_fd */
+        uint8_t coalesce_events;     /**< Non-zero queues at most one event of each type
+                                          per agent until the consumer reads it */
+        uint32_t max_event_subscribers; /**< Broadcast event cursors, 0 disables the ring */
+        uint32_t event_broadcast_size; /**< Broadcast ring capacity, 0 uses event_queue_size */
+        uint8_t event_overflow_policy; /**< PatikaOverflowPolicy for subscribers a ring behind */
+        uint32_t event_record_ring_size; /**< Bytes of the typed event record ring (records.h),
+                                              rounded up to a power of two, 0 disables */
+        uint8_t movement_deltas;     /**< Non-zero records each tick's agent moves, see
+                                          patika_get_movement_deltas */
+        uint8_t snapshot_soa;        /**< Non-zero fills PatikaSnapshot.columns instead of
+                                          the agents array */
+        const char *journal_path;    /**< Optional: record every tick's executed commands
+                                          here for patika_replay, NULL disables; creation
+                                          fails if the file cannot be created */
     } PatikaConfig;
 
     #ifdef __cplusplus
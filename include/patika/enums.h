@@ -17,9 +17,35 @@ extern "C" {
         PATIKA_ERR_CAPACITY = 4,
         PATIKA_ERR_BUSY = 5,
         PATIKA_ERR_NULL_HANDLE = 6,
-        PATIKA_ERR_INVALID_COMMAND_TYPE = 7
+        PATIKA_ERR_INVALID_COMMAND_TYPE = 7,
+        PATIKA_ERR_TIMEOUT = 8,
+        PATIKA_ERR_BAD_STREAM = 9,
+        PATIKA_ERR_IO = 10,
+        PATIKA_ERR_LAGGED = 11
     } PatikaError;
 
+    /**
+     * @brief How patika_submit_batch handles a queue without room for all commands
+     */
+    typedef enum
+    {
+        PATIKA_SUBMIT_ALL_OR_NOTHING = 0, /**< accept every command or none */
+        PATIKA_SUBMIT_PARTIAL = 1         /**< accept the longest prefix that fits */
+    } PatikaSubmitMode;
+
+    /**
+     * @brief What the event broadcast ring does when a subscriber falls a full ring behind
+     */
+    typedef enum
+    {
+        PATIKA_OVERFLOW_DROP_OLDEST = 0, /**< overwrite; the subscriber skips to the oldest
+                                              event left and counts the rest as dropped */
+        PATIKA_OVERFLOW_LAG = 1,         /**< as drop-oldest, but the subscriber's next peek
+                                              reports PATIKA_ERR_LAGGED once */
+        PATIKA_OVERFLOW_BLOCK = 2        /**< the simulation thread waits for the slowest
+                                              subscriber, stalling the tick */
+    } PatikaOverflowPolicy;
+
     /**
      * @brief Command types accepted by the simulation
      */
@@ -63,6 +89,12 @@ extern "C" {
         // Debug
         CMD_DEBUG_DUMP_STATE = 20,
 
+        // Agent lifecycle (waves)
+        CMD_ADD_AGENTS_BULK = 21,
+
+        // Scheduling (submitted by patika_schedule_command)
+        CMD_SCHEDULE = 22,
+
     } CommandType;
 
     /**
@@ -74,9 +106,14 @@ extern "C" {
         EVENT_STUCK = 1,
         EVENT_BLOCKED = 2,
         EVENT_REPLAN_NEEDED = 3,
-        EVENT_AGENT_REMOVED = 4
+        EVENT_AGENT_REMOVED = 4,
+        EVENT_OVERFLOW = 5,      /**< events were lost before this one: pos_q holds how
+                                      many (saturated), agent_id is invalid; resync */
+        EVENT_INTERACTION = 6    /**< typed event records only (records.h) */
     } EventType;
 
+    #define PATIKA_EVENT_TYPE_COUNT (EVENT_INTERACTION + 1)
+
     /**
      * @brief Map type identifiers
      */
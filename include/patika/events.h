@@ -19,6 +19,34 @@ extern "C" {
         int32_t pos_q, pos_r;
     } PatikaEvent;
 
+    /** @brief Filter bit for an event type, side or faction (31 and up share bit 31) */
+    #define PATIKA_EVENT_BIT(v) (1u << ((uint32_t)(v) < 31u ? (uint32_t)(v) : 31u))
+
+    /**
+     * @brief Which events a sink wants, checked before they are queued
+     * @details An event passes when its type, and its agent's side and
+     *          faction, all have their bit set.
+     */
+    typedef struct
+    {
+        uint32_t type_mask;    /**< PATIKA_EVENT_BIT(EventType) per wanted type */
+        uint32_t side_mask;    /**< PATIKA_EVENT_BIT(side) per wanted side */
+        uint32_t faction_mask; /**< PATIKA_EVENT_BIT(faction) per wanted faction */
+    } PatikaEventFilter;
+
+    /**
+     * @brief Events readable in place, from patika_peek_events
+     * @details first holds the oldest events; second is the part that
+     *          wrapped around the ring and is empty otherwise.
+     */
+    typedef struct
+    {
+        const PatikaEvent *first;
+        uint32_t first_count;
+        const PatikaEvent *second;
+        uint32_t second_count;
+    } PatikaEventSpan;
+
     #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,98 @@
+#ifndef PATIKA_RECORDS_H
+#define PATIKA_RECORDS_H
+
+/**
+ * @file records.h
+ * @brief Variable-size typed event records (config.event_record_ring_size)
+ * @details Records are read from patika_poll_event_records as a packed
+ *          byte block: a PatikaEventRecord header followed by a body whose
+ *          struct depends on the type. Walk the block with
+ *          patika_record_next and read bodies through the generated
+ *          accessors, e.g. patika_record_interaction(rec), which return
+ *          NULL for a record of another type.
+ */
+
+#include "types.h"
+#include "enums.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+    /**
+     * @brief Record header, the body follows it 8-byte aligned
+     */
+    typedef struct
+    {
+        uint16_t type; /**< EventType */
+        uint16_t size; /**< whole record in bytes, header included, a multiple of 8 */
+        uint32_t tick; /**< low 32 bits of the tick that emitted it */
+    } PatikaEventRecord;
+
+    /**
+     * @brief Body of the agent events, as in PatikaEvent plus the agent's tags
+     */
+    typedef struct
+    {
+        AgentID agent_id;
+        int32_t pos_q, pos_r;
+        BuildingID barrack_id; /**< parent barrack, PATIKA_INVALID_BARRACK_ID if none */
+        uint8_t side;
+        uint8_t faction;
+    } PatikaAgentRecord;
+
+    /**
+     * @brief Body of EVENT_INTERACTION: an agent moved onto another it interacts with
+     */
+    typedef struct
+    {
+        AgentID agent_id;
+        AgentID target_id;
+        int32_t pos_q, pos_r;  /**< tile the two agents share */
+        uint8_t interaction;   /**< InteractionType */
+    } PatikaInteractionRecord;
+
+    /**
+     * @brief Body of EVENT_OVERFLOW: records were lost before this one
+     */
+    typedef struct
+    {
+        uint32_t lost; /**< how many, saturated */
+    } PatikaOverflowRecord;
+
+    /**
+     * @brief Every record type: X(EventType, accessor name, body struct)
+     */
+    #define PATIKA_EVENT_RECORDS(X)                                   \
+        X(EVENT_REACHED_GOAL, reached_goal, PatikaAgentRecord)        \
+        X(EVENT_STUCK, stuck, PatikaAgentRecord)                      \
+        X(EVENT_BLOCKED, blocked, PatikaAgentRecord)                  \
+        X(EVENT_REPLAN_NEEDED, replan_needed, PatikaAgentRecord)      \
+        X(EVENT_AGENT_REMOVED, agent_removed, PatikaAgentRecord)      \
+        X(EVENT_OVERFLOW, overflow, PatikaOverflowRecord)             \
+        X(EVENT_INTERACTION, interaction, PatikaInteractionRecord)
+
+    /** @brief Size of a record with the given body, header and padding included */
+    #define PATIKA_RECORD_SIZE(body_size) \
+        ((uint32_t)((sizeof(PatikaEventRecord) + (body_size) + 7u) & ~(size_t)7u))
+
+    /** @brief The record after rec in a block from patika_poll_event_records */
+    static inline const PatikaEventRecord *patika_record_next(const PatikaEventRecord *rec)
+    {
+        return (const PatikaEventRecord *)((const uint8_t *)rec + rec->size);
+    }
+
+    #define PATIKA_RECORD_ACCESSOR(type_, name_, body_)                                \
+        static inline const body_ *patika_record_##name_(const PatikaEventRecord *rec) \
+        {                                                                              \
+            return rec->type == (type_) ? (const body_ *)(rec + 1) : NULL;             \
+        }
+    PATIKA_EVENT_RECORDS(PATIKA_RECORD_ACCESSOR)
+    #undef PATIKA_RECORD_ACCESSOR
+
+    #ifdef __cplusplus
+}
+#endif
+
+#endif /* PATIKA_RECORDS_H */
@@ -39,12 +39,50 @@ extern "C" {
         uint16_t agent_count;
     } BarrackSnapshot;
 
+    /**
+     * @brief One agent's new tile, packed for replication
+     * @details agent_index is the slot part of the AgentID: its low 16 bits,
+     *          or low 32 with PATIKA_WIDE_AGENT_IDS. Coordinates fit maps up
+     *          to 32767 cells per axis.
+     */
+    typedef struct
+    {
+        uint32_t agent_index;
+        int16_t q, r;
+    } PatikaMovementDelta;
+
+    /**
+     * @brief Every position change of one tick, in the order they happened
+     */
+    typedef struct
+    {
+        const PatikaMovementDelta *deltas;
+        uint32_t count;
+        uint64_t tick; /**< PatikaStats.total_ticks of the tick that moved them */
+    } PatikaMovementDeltas;
+
+    /**
+     * @brief Agent snapshot as one array per field (config.snapshot_soa)
+     * @details Every array starts on a 64-byte boundary and holds
+     *          PatikaSnapshot.agent_count entries; entry i of each array
+     *          describes the same agent.
+     */
+    typedef struct
+    {
+        AgentID *id;
+        int32_t *pos_q;
+        int32_t *pos_r;
+        uint8_t *state;   /**< AgentState */
+        uint8_t *faction;
+    } PatikaAgentColumns;
+
     /**
      * @brief Consistent snapshot view of the world
      */
     typedef struct
     {
-        AgentSnapshot *agents;
+        AgentSnapshot *agents;       /**< NULL with config.snapshot_soa */
+        PatikaAgentColumns columns;  /**< NULL arrays unless config.snapshot_soa */
         uint32_t agent_count;
         BarrackSnapshot *barracks;
         uint16_t barrack_count;
@@ -63,8 +101,46 @@ extern "C" {
         uint64_t replan_count;
         uint32_t active_agents;
         uint32_t active_barracks;
+        uint64_t commands_coalesced; /**< dropped before processing as redundant */
+        uint32_t command_queue_high_watermark; /**< most commands found in the shared queue at a tick */
+        uint64_t submit_waits;       /**< times patika_submit_command_wait parked */
+        uint64_t submit_wait_ns;     /**< total time spent parked */
+        uint32_t scheduled_commands; /**< waiting in the timing wheel */
+        uint32_t command_backlog;    /**< left queued after the last tick */
+        uint64_t command_backlog_ticks; /**< consecutive ticks ending with a backlog, bounds
+                                             the age of the oldest queued command */
+        uint64_t command_budget_hits; /**< ticks cut short by the command budget */
+        uint64_t events_filtered;    /**< emitted events no filter accepted */
+        uint64_t events_dropped[PATIKA_EVENT_TYPE_COUNT]; /**< lost to a full event queue */
+        uint64_t events_coalesced;   /**< skipped, same type already queued for the agent */
+        uint64_t event_wakeups;      /**< times waiting event consumers were signalled */
+        uint64_t event_records_dropped; /**< lost to a full event record ring */
+        uint64_t snapshots_skipped;  /**< ticks that kept the previous snapshot because
+                                          readers had every spare buffer pinned */
+        uint32_t snapshot_entries_copied; /**< agent entries the last snapshot update
+                                               rewrote; unchanged ones are left alone */
     } PatikaStats;
 
+    /**
+     * @brief Per-producer command lane counters
+     */
+    typedef struct
+    {
+        uint64_t submitted;  /**< commands accepted into the lane */
+        uint64_t queue_full; /**< submissions rejected or cut short by a full lane */
+        uint32_t pending;    /**< commands waiting for the next tick */
+    } PatikaLaneStats;
+
+    /**
+     * @brief Per-subscriber broadcast cursor counters
+     */
+    typedef struct
+    {
+        uint64_t delivered; /**< events committed intact */
+        uint64_t dropped;   /**< events overwritten before they were read */
+        uint64_t pending;   /**< events published but not yet committed */
+    } PatikaCursorStats;
+
     #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,70 @@
+#ifndef PATIKA_STREAM_H
+#define PATIKA_STREAM_H
+
+#include "types.h"
+#include "enums.h"
+#include "commands/base.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file stream.h
+ * @brief Binary command stream, for the wire and for command logs
+ * @details All fields are little-endian and unaligned.
+ *
+ *          Stream header (8 bytes):
+ *            u32 magic "PTKS", u8 version, u8 flags, u16 reserved (0)
+ *
+ *          Then records, back to back. Record header (8 bytes):
+ *            u16 CommandType, u16 reserved (0), u32 body length in bytes
+ *
+ *          Record bodies (ID = AgentID, 4 bytes, or 8 with
+ *          PATIKA_STREAM_FLAG_WIDE_AGENT_IDS):
+ *            CMD_SET_GOAL                 ID agent, i32 q, i32 r
+ *            CMD_REMOVE_AGENT             ID agent
+ *            CMD_SET_TILE_STATE           i32 q, i32 r, u8 state, 3 pad
+ *            CMD_ADD_AGENT                spawn record (16)
+ *            CMD_ADD_AGENT_WITH_BEHAVIOR  spawn record, u8 behavior, 3 pad,
+ *                                         i32 param0..2 (patrol center_q,
+ *                                         center_r, radius / explore mode)
+ *            CMD_ADD_AGENTS_BULK          u32 count, count spawn records
+ *            CMD_ADD_BARRACK              i32 q, i32 r, u8 faction, u8 side,
+ *                                         u8 behavior, u8 patrol_radius,
+ *                                         u16 max_agents, 2 pad
+ *
+ *          Spawn record (16 bytes): i32 q, i32 r, u8 faction, u8 side,
+ *          u16 parent_barrack, u8 layer, u8 collision_mask,
+ *          u8 aggression_mask, 1 pad.
+ *
+ *          Output pointers (out_agent_id and friends) are not encoded.
+ */
+
+#define PATIKA_STREAM_MAGIC 0x534B5450u /* "PTKS" */
+#define PATIKA_STREAM_VERSION 1
+#define PATIKA_STREAM_HEADER_SIZE 8
+#define PATIKA_STREAM_RECORD_HEADER_SIZE 8
+
+/** Agent IDs in the stream are 64-bit (PATIKA_WIDE_AGENT_IDS builds) */
+#define PATIKA_STREAM_FLAG_WIDE_AGENT_IDS (1u << 0)
+
+#ifdef __cplusplus
+extern "C" {
+    #endif
+
+    /**
+     * @brief Write a stream header for this build's agent ID width
+     * @return Bytes written, 0 if capacity is too small
+     */
+    PATIKA_API size_t patika_stream_write_header(uint8_t *out, size_t capacity);
+
+    /**
+     * @brief Append one command as a stream record
+     * @return Bytes written, 0 if the type has no encoding or capacity is too small
+     */
+    PATIKA_API size_t patika_stream_encode(const PatikaCommand *cmd, uint8_t *out, size_t capacity);
+
+    #ifdef __cplusplus
+}
+#endif
+
+#endif /* PATIKA_STREAM_H */
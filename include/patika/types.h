@@ -1,6 +1,7 @@
 #ifndef PATIKA_TYPES_H
 #define PATIKA_TYPES_H
 
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -26,16 +27,35 @@ extern "C" {
     #endif
     #endif
 
-    /** @brief Opaque agent identifier */
+    #ifdef PATIKA_WIDE_AGENT_IDS
+    /** @brief Opaque agent identifier (32-bit slot index, 32-bit generation) */
+    typedef uint64_t AgentID;
+    #define PATIKA_PRI_AGENT_ID PRIu64
+    /** @brief Largest agent pool, bounded by the 30-bit agent grid encoding */
+    #define PATIKA_MAX_AGENTS 0x3FFFFFFFu
+    #else
+    /** @brief Opaque agent identifier (16-bit slot index, 16-bit generation) */
     typedef uint32_t AgentID;
+    #define PATIKA_PRI_AGENT_ID PRIu32
+    /** @brief Largest agent pool, index 0xFFFF is reserved as invalid */
+    #define PATIKA_MAX_AGENTS 0xFFFFu
+    #endif
 
     /** @brief Opaque barrack identifier */
     typedef uint16_t BuildingID;
 
+    /** @brief Command lane handed to a producer by patika_register_producer */
+    typedef uint32_t PatikaProducerToken;
+    #define PATIKA_INVALID_PRODUCER_TOKEN 0xFFFFFFFFu
+
+    /** @brief Event broadcast subscription from patika_subscribe_events */
+    typedef uint32_t PatikaEventCursor;
+    #define PATIKA_INVALID_EVENT_CURSOR 0xFFFFFFFFu
+
     /** @brief Opaque simulation context handle */
     typedef struct PatikaContext *PatikaHandle;
 
-    PATIKA_API extern const uint32_t PATIKA_INVALID_AGENT_ID;
+    PATIKA_API extern const AgentID PATIKA_INVALID_AGENT_ID;
     PATIKA_API extern const uint16_t PATIKA_INVALID_BARRACK_ID;
 
     #ifdef __cplusplus
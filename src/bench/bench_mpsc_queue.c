@@ -0,0 +1,133 @@
+/**
+ * @file bench_mpsc_queue.c
+ * @brief Multi-producer throughput of the command queue
+ * @details P producer threads push a fixed number of commands each while one
+ *          consumer drains concurrently. Reports throughput and how often
+ *          producers found the queue full, for P = 1, 2, 4, 8, 16, once
+ *          through the shared queue and once through per-producer lanes.
+ *
+ *          Usage: bench_mpsc_queue [commands_per_producer] [queue_size]
+ */
+
+#include "internal/patika_internal.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    MPSCCommandQueue *queue;
+    CommandLane *lane;
+    uint32_t producer;
+    uint32_t count;
+    uint64_t full_retries;
+} ProducerArgs;
+
+static _Atomic int start_flag;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void *producer_main(void *arg)
+{
+    ProducerArgs *args = (ProducerArgs *)arg;
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_SET_GOAL;
+    cmd.set_goal.agent_id = args->producer;
+
+    while (!atomic_load_explicit(&start_flag, memory_order_acquire))
+        ;
+
+    for (uint32_t i = 0; i < args->count; i++)
+    {
+        cmd.set_goal.goal_q = (int32_t)i;
+        if (args->lane)
+        {
+            while (lane_push_batch(args->lane, &cmd, 1, PATIKA_SUBMIT_ALL_OR_NOTHING) != 1)
+                args->full_retries++;
+        }
+        else
+        {
+            while (mpsc_push(args->queue, &cmd) != PATIKA_OK)
+                args->full_retries++;
+        }
+    }
+    return NULL;
+}
+
+static void run(uint32_t producers, uint32_t per_producer, uint32_t queue_size, int use_lanes)
+{
+    MPSCCommandQueue queue;
+    CommandLanes lanes;
+    mpsc_init(&queue, queue_size);
+    lanes_init(&lanes, use_lanes ? producers : 0, queue_size / producers);
+
+    pthread_t threads[16];
+    ProducerArgs args[16];
+    atomic_store(&start_flag, 0);
+
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        args[p] = (ProducerArgs){&queue, use_lanes ? &lanes.lanes[p] : NULL, p, per_producer, 0};
+        pthread_create(&threads[p], NULL, producer_main, &args[p]);
+    }
+
+    uint64_t total = (uint64_t)producers * per_producer;
+    uint64_t popped = 0;
+    uint64_t empty_polls = 0;
+    PatikaCommand out;
+
+    double t0 = now_sec();
+    atomic_store_explicit(&start_flag, 1, memory_order_release);
+    while (popped < total)
+    {
+        uint64_t before = popped;
+        while (mpsc_pop(&queue, &out) == PATIKA_OK)
+            popped++;
+        for (uint32_t p = 0; p < lanes.max_lanes; p++)
+        {
+            while (lane_pop(&lanes.lanes[p], &out) == PATIKA_OK)
+                popped++;
+        }
+        if (popped == before)
+            empty_polls++;
+    }
+    double elapsed = now_sec() - t0;
+
+    uint64_t full_retries = 0;
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        pthread_join(threads[p], NULL);
+        full_retries += args[p].full_retries;
+    }
+
+    printf("%s %2u producers  %8.2f Mcmd/s  %8.1f ns/cmd  full-retries/cmd %6.2f  empty-polls/cmd %6.2f\n",
+           use_lanes ? "lanes" : "queue", producers, (double)total / elapsed / 1e6, elapsed * 1e9 / (double)total,
+           (double)full_retries / (double)total, (double)empty_polls / (double)total);
+
+    mpsc_destroy(&queue);
+    lanes_destroy(&lanes);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t per_producer = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+    uint32_t queue_size = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 65536;
+
+    printf("mpsc queue: %u commands per producer, capacity %u, sizeof(PatikaCommand) %zu\n",
+           per_producer, queue_size, sizeof(PatikaCommand));
+
+    static const uint32_t PRODUCERS[] = {1, 2, 4, 8, 16};
+    for (int use_lanes = 0; use_lanes < 2; use_lanes++)
+    {
+        for (size_t i = 0; i < sizeof(PRODUCERS) / sizeof(PRODUCERS[0]); i++)
+        {
+            run(PRODUCERS[i], per_producer / PRODUCERS[i], queue_size, use_lanes);
+        }
+    }
+    return 0;
+}
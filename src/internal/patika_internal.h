@@ -10,15 +10,35 @@
 #define INT32_MAX 0x7FFFFFFF
 #endif
 
+/* Agent grid cells are 32-bit in both ID layouts: two flag bits on top and
+ * the slot index below. Wide IDs only widen the index part of the cell. */
+#ifdef PATIKA_WIDE_AGENT_IDS
+typedef uint32_t AgentIndex;
+typedef uint32_t AgentGeneration;
+#define PATIKA_AGENT_INDEX_BITS 32
+#define PATIKA_INVALID_AGENT_INDEX 0x3FFFFFFFu
+#define AGENT_GRID_AGENT_MASK    0x3FFFFFFF  // Lower 30 bits
+#else
+typedef uint16_t AgentIndex;
+typedef uint16_t AgentGeneration;
+#define PATIKA_AGENT_INDEX_BITS 16
 #define PATIKA_INVALID_AGENT_INDEX 0xFFFFu
+#define AGENT_GRID_AGENT_MASK    0x0000FFFF  // Lower 16 bits
+#endif
+
 #define PATIKA_AGENT_DEFAULT_VIEW_RADIUS 1
 
 #define AGENT_GRID_RESERVED_BIT  0x80000000  // Bit 31
 #define AGENT_GRID_OCCUPIED_BIT  0x40000000  // Bit 30 (future use)
-#define AGENT_GRID_AGENT_MASK    0x0000FFFF  // Lower 16 bits
 
 #define AGENT_PROGRESS_MAX_DISTANCE 10000
 
+#if defined(_MSC_VER)
+#define PATIKA_THREAD_LOCAL __declspec(thread)
+#else
+#define PATIKA_THREAD_LOCAL _Thread_local
+#endif
+
 #define PATIKA_INTERNAL_LOG_DEBUG(fmt, ...) PATIKA_LOG_DEBUG("[CORE] " fmt, ##__VA_ARGS__)
 #define PATIKA_INTERNAL_LOG_INFO(fmt, ...) PATIKA_LOG_INFO("[CORE] " fmt, ##__VA_ARGS__)
 #define PATIKA_INTERNAL_LOG_WARN(fmt, ...) PATIKA_LOG_WARN("[CORE] " fmt, ##__VA_ARGS__)
@@ -33,19 +53,263 @@ typedef struct BarrackPool BarrackPool;
 typedef struct MapTile MapTile;
 typedef struct MapGrid MapGrid;
 typedef struct PCG32 PCG32;
+typedef struct PayloadSlab PayloadSlab;
+typedef struct PayloadPool PayloadPool;
+
+#define PATIKA_CACHE_LINE 64
 
+typedef struct {
+    _Atomic uint32_t sequence;
+    PatikaCommand cmd;
+} MPSCSlot;
+
+/* head and tail sit on their own cache lines, padding instead of _Alignas
+ * because the context is heap allocated with plain calloc */
 struct MPSCCommandQueue
 {
-    PatikaCommand *buffer;
-    uint32_t capacity;
-    _Atomic uint32_t head;
-    uint32_t tail;
+    MPSCSlot *slots;
+    uint32_t capacity; // power of two
+    uint32_t mask;
+    char pad0[PATIKA_CACHE_LINE];
+    _Atomic uint32_t head; // next enqueue position, shared by producers
+    char pad1[PATIKA_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t tail;         // next dequeue position, consumer only
+    char pad2[PATIKA_CACHE_LINE - sizeof(uint32_t)];
 };
 
 void mpsc_init(MPSCCommandQueue *q, uint32_t capacity);
 void mpsc_destroy(MPSCCommandQueue *q);
 PatikaError mpsc_push(MPSCCommandQueue *q, const PatikaCommand *cmd);
 PatikaError mpsc_pop(MPSCCommandQueue *q, PatikaCommand *out);
+uint32_t mpsc_reserve(MPSCCommandQueue *q, uint32_t n, uint32_t min_count, uint32_t *out_pos);
+void mpsc_publish(MPSCCommandQueue *q, uint32_t pos, uint32_t count);
+
+static inline PatikaCommand *mpsc_slot_command(MPSCCommandQueue *q, uint32_t pos)
+{
+    return &q->slots[pos & q->mask].cmd;
+}
+
+/* Single-producer command lane. Producer and consumer indices each sit on a
+ * line of their own, with a cached copy of the other side's index so the
+ * fast path touches no shared line. */
+typedef struct
+{
+    PatikaCommand *buffer;
+    uint32_t capacity; // power of two
+    uint32_t mask;
+    char pad0[PATIKA_CACHE_LINE];
+    _Atomic uint32_t head;       // producer
+    uint32_t cached_tail;        // producer's last view of tail
+    _Atomic uint64_t submitted;  // producer writes, stats read
+    _Atomic uint64_t queue_full; // producer writes, stats read
+    char pad1[PATIKA_CACHE_LINE - 24];
+    _Atomic uint32_t tail;       // consumer
+    uint32_t cached_head;        // consumer's last view of head
+    char pad2[PATIKA_CACHE_LINE - 8];
+} CommandLane;
+
+typedef struct
+{
+    CommandLane *lanes; // allocated up front, registration only hands out ids
+    uint32_t max_lanes;
+    _Atomic uint32_t registered;
+} CommandLanes;
+
+void lanes_init(CommandLanes *l, uint32_t max_lanes, uint32_t lane_size);
+void lanes_destroy(CommandLanes *l);
+uint32_t lanes_register(CommandLanes *l);
+uint32_t lane_push_batch(CommandLane *lane, const PatikaCommand *cmds, uint32_t count, PatikaSubmitMode mode);
+PatikaError lane_pop(CommandLane *lane, PatikaCommand *out);
+
+/* Platform: monotonic clock and address wait/wake (patika_platform.c) */
+uint64_t patika_now_ns(void);
+void patika_wait_on_address(_Atomic uint32_t *addr, uint32_t expected, uint64_t timeout_ns);
+void patika_wake_address(_Atomic uint32_t *addr);
+
+typedef struct
+{
+    uint8_t *base;
+    size_t size;
+    intptr_t file; // fd or HANDLE
+    int writable;
+} MappedFile;
+
+int mapped_file_create(MappedFile *f, const char *path, size_t size);
+int mapped_file_open_read(MappedFile *f, const char *path);
+int mapped_file_resize(MappedFile *f, size_t size); // base may move
+void mapped_file_close(MappedFile *f, size_t final_size);
+
+/**
+ * @brief Non-blocking eventfd, -1 where unsupported
+ */
+int patika_eventfd_create(void);
+void patika_eventfd_signal(int fd);
+void patika_eventfd_close(int fd);
+
+/* Producers parked by patika_submit_command_wait */
+typedef struct
+{
+    _Atomic uint32_t space_seq; // bumped by the sim thread after freeing slots
+    _Atomic uint32_t waiters;
+    _Atomic uint64_t wait_count;
+    _Atomic uint64_t wait_ns;
+} SubmitWaiters;
+
+/* Event consumers parked by patika_wait_events or sleeping in epoll */
+typedef struct
+{
+    _Atomic uint32_t seq;     // bumped by the sim thread on each signal
+    _Atomic uint32_t waiters;
+    _Atomic uint32_t armed;   // a consumer saw the queue empty and wants a signal
+    int fd;                   // eventfd, -1 without config.event_notify_fd
+} EventWaiters;
+
+/* Timing wheel for patika_schedule_command (patika_schedule.c) */
+#define PATIKA_WHEEL_LEVELS 4
+#define PATIKA_WHEEL_BITS 8
+#define PATIKA_WHEEL_SLOTS (1u << PATIKA_WHEEL_BITS)
+
+/* CMD_SCHEDULE payload, doubles as the wheel node */
+typedef struct ScheduledCommand
+{
+    struct ScheduledCommand *next;
+    uint64_t tick;
+    PatikaCommand cmd;
+} ScheduledCommand;
+
+typedef struct
+{
+    ScheduledCommand *head;
+    ScheduledCommand *tail;
+} ScheduleList;
+
+typedef struct
+{
+    ScheduleList slots[PATIKA_WHEEL_LEVELS][PATIKA_WHEEL_SLOTS];
+    ScheduleList overflow; // more than 2^32 ticks ahead
+    ScheduleList late;     // already due when dequeued, run after the batch
+    uint64_t now;          // last tick whose level 0 slot was fired
+    uint32_t pending;
+} TimingWheel;
+
+void schedule_insert(struct PatikaContext *ctx, ScheduledCommand *node);
+
+/**
+ * @brief Advance the wheel to tick and process every command due on it
+ */
+void schedule_fire(struct PatikaContext *ctx, uint64_t tick);
+
+/**
+ * @brief Process the commands that were already due when the batch dequeued them
+ */
+void schedule_run_late(struct PatikaContext *ctx);
+
+/**
+ * @brief Release every pending command and its payload
+ */
+void schedule_destroy(TimingWheel *w);
+
+/* Binary command stream (patika_stream.c) */
+PatikaError stream_check_header(const uint8_t *p, size_t len);
+
+/**
+ * @brief Check record framing and body sizes, without the stream header
+ */
+PatikaError stream_validate_records(const uint8_t *p, size_t len, uint32_t *out_count);
+
+/**
+ * @brief Decode one validated record, payloads come from the calling thread's slab
+ * @return Start of the next record
+ */
+const uint8_t *stream_decode_record(PayloadPool *payloads, const uint8_t *p, PatikaCommand *out);
+
+/**
+ * @brief Encoded record size, 0 for commands without an encoding
+ */
+size_t stream_encoded_size(const PatikaCommand *cmd);
+
+/* Command journal (patika_journal.c): one block per tick of the commands
+ * actually executed, in stream record format, with a tick index at close */
+typedef struct
+{
+    MappedFile file;
+    size_t used;
+    size_t block_start;   // header of the open tick block
+    uint32_t block_count; // records in the open block
+    uint64_t *index;      // block offset per tick
+    uint64_t index_count;
+    uint64_t index_capacity;
+} CommandJournal;
+
+int journal_open(CommandJournal *j, const char *path);
+void journal_close(CommandJournal *j);
+void journal_begin_tick(CommandJournal *j, uint64_t tick);
+void journal_record(CommandJournal *j, const PatikaCommand *cmd);
+void journal_end_tick(CommandJournal *j);
+
+static inline int journal_active(const CommandJournal *j)
+{
+    return j->file.base != NULL;
+}
+
+/* Commands drained from the queue and lanes for the current tick */
+typedef struct
+{
+    PatikaCommand *cmds;
+    PatikaCommand *sorted; // phase-ordered copy, only with config.sort_commands
+    uint32_t count;
+    uint32_t capacity; // shared queue plus every lane, one lap each
+    uint32_t *quota;   // per source (shared queue, then lanes) under a tick limit
+    uint32_t *pending;
+    uint32_t next_source; // first to get a leftover slot, rotates per drain
+} CommandBatch;
+
+/* Marks are live while their epoch equals the coalescer's current epoch */
+typedef struct
+{
+    uint32_t goal_epoch;
+    uint32_t remove_epoch;
+    AgentID goal_id;
+    AgentID remove_id;
+} CoalesceAgentMark;
+
+typedef struct
+{
+    CoalesceAgentMark *agents; // per agent slot
+    uint32_t *tiles;           // per map tile
+    uint32_t agent_count;
+    uint32_t tile_count;
+    uint32_t agent_epoch;
+    uint32_t tile_epoch;
+} CommandCoalescer;
+
+void coalescer_init(CommandCoalescer *c, uint32_t agent_count, uint32_t tile_count);
+void coalescer_destroy(CommandCoalescer *c);
+
+/**
+ * @brief Drop commands whose effect is overwritten later in the same batch
+ * @return New command count, survivors keep their relative order
+ */
+uint32_t coalesce_commands(struct PatikaContext *ctx, PatikaCommand *cmds, uint32_t count);
+
+/* Per-producer-thread slabs for large command payloads */
+struct PayloadPool
+{
+    _Atomic(PayloadSlab *) slabs; // registry, push-only until destroy
+    uint64_t serial;              // tells a recycled context address apart
+};
+
+void payload_pool_init(PayloadPool *pool);
+void payload_pool_destroy(PayloadPool *pool);
+void *payload_pool_alloc(PayloadPool *pool, size_t size);
+void payload_pool_release(void *payload);
+
+int command_has_payload(CommandType type);
+
+/**
+ * @brief Release cmd->large_command.payload with the allocator it came from
+ */
+void command_release_payload(const PatikaCommand *cmd);
 
 struct SPSCEventQueue
 {
@@ -55,10 +319,161 @@ struct SPSCEventQueue
     _Atomic uint32_t tail;
 };
 
+/* Readable events in ring order, the second run is the wrapped part */
+typedef struct
+{
+    const PatikaEvent *first;
+    uint32_t first_count;
+    const PatikaEvent *second;
+    uint32_t second_count;
+} SPSCSpan;
+
 void spsc_init(SPSCEventQueue *q, uint32_t capacity);
 void spsc_destroy(SPSCEventQueue *q);
 PatikaError spsc_push(SPSCEventQueue *q, const PatikaEvent *evt);
 PatikaError spsc_pop(SPSCEventQueue *q, PatikaEvent *out);
+uint32_t spsc_pop_bulk(SPSCEventQueue *q, PatikaEvent *out, uint32_t max);
+uint32_t spsc_peek(SPSCEventQueue *q, uint32_t max, SPSCSpan *out);
+void spsc_commit(SPSCEventQueue *q, uint32_t count);
+
+/* Broadcast event ring (patika_events.c) */
+enum
+{
+    SUBSCRIBER_FREE = 0,
+    SUBSCRIBER_CLAIMED = 1, // cursor being set up
+    SUBSCRIBER_ACTIVE = 2
+};
+
+/* Event filter written by a consumer thread, read by the simulation thread
+ * once per change */
+typedef struct
+{
+    _Atomic uint32_t type_mask;
+    _Atomic uint32_t side_mask;
+    _Atomic uint32_t faction_mask;
+} EventFilterSlot;
+
+typedef struct
+{
+    _Atomic uint64_t cursor; // next position to read, owned by the subscriber
+    _Atomic uint64_t delivered;
+    _Atomic uint64_t dropped;
+    _Atomic uint32_t state;
+    EventFilterSlot filter;
+    char pad[PATIKA_CACHE_LINE - 40];
+} EventSubscriber;
+
+typedef struct
+{
+    PatikaEvent *slots;
+    uint32_t capacity; // power of two
+    uint32_t mask;
+    uint8_t policy;      // PatikaOverflowPolicy
+    uint64_t min_cursor; // producer's last view of the slowest cursor (block policy)
+    EventSubscriber *subs;
+    uint32_t max_subs;
+    char pad0[PATIKA_CACHE_LINE];
+    _Atomic uint64_t head;             // events published
+    _Atomic uint32_t space_seq;        // bumped by readers when the producer parks
+    _Atomic uint32_t producer_waiting;
+    char pad1[PATIKA_CACHE_LINE - 16];
+} EventBroadcast;
+
+void broadcast_init(EventBroadcast *b, uint32_t capacity, uint32_t max_subs, uint8_t policy);
+void broadcast_destroy(EventBroadcast *b);
+void broadcast_publish(EventBroadcast *b, const PatikaEvent *evt);
+
+/* Emit-time filters: the simulation thread keeps a plain copy of every
+ * sink's filter and rebuilds it when seq moves */
+typedef struct
+{
+    EventFilterSlot queue;      // patika_set_event_filter
+    _Atomic uint32_t seq;       // bumped after any filter or subscription change
+    uint32_t seen_seq;          // seq of the last rebuild
+    uint32_t type_union;        // event types at least one sink wants
+    PatikaEventFilter queue_copy;
+    PatikaEventFilter *subs_copy; // active subscribers' filters
+    uint32_t subs_count;
+} EventFilters;
+
+void event_filters_init(EventFilters *f, uint32_t max_subs);
+void event_filters_destroy(EventFilters *f);
+
+/* Event queue overflow accounting and per-agent coalescing */
+typedef struct
+{
+    uint64_t pending_drops;   // lost since the last EVENT_OVERFLOW record
+    _Atomic uint64_t *pending; // per agent slot: generation << 8 | bit per queued type
+    uint32_t pending_slots;   // 0 unless config.coalesce_events
+} EventOverflow;
+
+void event_overflow_init(EventOverflow *o, uint32_t max_agents, int coalesce);
+void event_overflow_destroy(EventOverflow *o);
+
+/**
+ * @brief Queue the EVENT_OVERFLOW record owed for earlier drops, if any
+ * @return 0 if the event queue is still full
+ */
+int event_flush_overflow(struct PatikaContext *ctx);
+
+/**
+ * @brief Consumer side: events read from the queue no longer block coalescing
+ */
+void event_release_pending(struct PatikaContext *ctx, const PatikaEvent *events, uint32_t count);
+
+void event_waiters_init(EventWaiters *w, int want_fd);
+void event_waiters_destroy(EventWaiters *w);
+
+/**
+ * @brief Consumer side: ask for a signal once events arrive
+ * @details Call after finding the queue empty, then check it again.
+ */
+void event_waiters_arm(EventWaiters *w);
+
+/**
+ * @brief Simulation thread, end of tick: wake armed consumers if events are queued
+ */
+void event_waiters_signal(struct PatikaContext *ctx);
+
+/**
+ * @brief Deliver an agent's event to the event queue and broadcast ring, if
+ *        any of their filters accept it, and to the record ring
+ */
+void emit_event(struct PatikaContext *ctx, const PatikaEvent *evt, const AgentSlot *agent);
+
+/* Typed event records (patika_records.c): length-prefixed records in a byte
+ * ring, the simulation thread writes and one consumer polls */
+typedef struct
+{
+    uint8_t *buffer;
+    uint32_t capacity;     // power of two, 0 when disabled
+    uint32_t mask;
+    uint64_t pending_lost; // dropped since the last EVENT_OVERFLOW record
+    char pad0[PATIKA_CACHE_LINE];
+    _Atomic uint32_t head; // bytes written
+    char pad1[PATIKA_CACHE_LINE - sizeof(uint32_t)];
+    _Atomic uint32_t tail; // bytes read
+    char pad2[PATIKA_CACHE_LINE - sizeof(uint32_t)];
+} EventRecordRing;
+
+void record_ring_init(EventRecordRing *r, uint32_t capacity);
+void record_ring_destroy(EventRecordRing *r);
+
+/**
+ * @brief Append a record to the record ring, a no-op when it is disabled
+ * @details A full ring drops the record and owes the consumer an
+ *          EVENT_OVERFLOW record ahead of the next one that fits.
+ */
+void emit_record(struct PatikaContext *ctx, uint16_t type, const void *body, uint32_t body_size);
+
+/* emit_record_<name>(ctx, body) for every type in PATIKA_EVENT_RECORDS */
+#define RECORD_EMITTER(type_, name_, body_)                                          \
+    static inline void emit_record_##name_(struct PatikaContext *ctx, const body_ *body) \
+    {                                                                                \
+        emit_record(ctx, (uint16_t)(type_), body, (uint32_t)sizeof(body_));          \
+    }
+PATIKA_EVENT_RECORDS(RECORD_EMITTER)
+#undef RECORD_EMITTER
 
 typedef struct {
     int32_t center_q, center_r;
@@ -91,11 +506,11 @@ struct AgentSlot
     BuildingID parent_barrack;
     AgentInteraction interaction_data;
 
-    uint16_t generation;
+    AgentGeneration generation;
+    AgentIndex next_free_index;
     uint16_t progress; // 0-10000
     uint16_t view_radius;
     uint16_t speed; // tick based
-    uint16_t next_free_index;
 
     PatikaCollisionData collision_data;
     uint8_t state;
@@ -112,11 +527,36 @@ struct AgentSlot
 
 };
 
+#define PATIKA_AGENT_STATE_COUNT 5
+
+/* Packed work list of agents sharing one AgentState */
+typedef struct {
+    uint32_t *indices;
+    uint32_t count;
+} AgentStateList;
+
+/* Published snapshot, one being written, one spare for a reader that pins
+ * the published one across ticks */
+#define PATIKA_SNAPSHOT_BUFFERS 3
+
+/* Positions in active_list whose AgentSnapshot entry one snapshot buffer
+ * has not seen yet. Entry i of every buffer mirrors active_list[i]. */
+typedef struct {
+    uint32_t *positions;
+    uint8_t *marked; // by position, set while listed
+    uint32_t count;
+} SnapshotDirtyList;
+
 struct AgentPool
 {
     AgentSlot *slots;
+    uint32_t *active_list; // packed indices of live slots, [0, active_count)
+    uint32_t *active_pos;  // slot index -> position in active_list
+    AgentStateList state_lists[PATIKA_AGENT_STATE_COUNT]; // STATE_IDLE has no list
+    uint32_t *state_pos;   // slot index -> position in its state list
+    SnapshotDirtyList snapshot_dirty[PATIKA_SNAPSHOT_BUFFERS];
     uint32_t capacity;
-    uint16_t free_head;
+    AgentIndex free_head;
     uint32_t active_count;
 };
 
@@ -128,17 +568,59 @@ AgentID agent_pool_allocate(AgentPool *pool);
 void agent_pool_free(AgentPool *pool, AgentID id);
 AgentSlot *agent_pool_get(AgentPool *pool, AgentID id);
 
-static inline AgentID make_agent_id(uint16_t index, uint16_t gen)
+/**
+ * @brief Live agent in a slot, by the bare index the agent grid stores
+ * @details The grid keeps no generation, so agent_pool_get cannot be used
+ *          on it; callers check the agent is really on the tile.
+ */
+static inline AgentSlot *agent_pool_slot(AgentPool *pool, AgentIndex index)
 {
-    return ((uint32_t)gen << 16) | index;
+    if (index >= pool->capacity || !pool->slots[index].active)
+        return NULL;
+    return &pool->slots[index];
 }
-static inline uint16_t agent_index(AgentID id)
+
+/**
+ * @brief Change agent state and move it to the matching work list
+ * @details Every state transition must go through here, tick phases only
+ *          visit the list of the state they handle.
+ */
+void agent_set_state(AgentPool *pool, AgentSlot *agent, uint8_t state);
+
+static inline void agent_mark_position_dirty(AgentPool *pool, uint32_t pos)
+{
+    for (uint32_t b = 0; b < PATIKA_SNAPSHOT_BUFFERS; b++)
+    {
+        SnapshotDirtyList *list = &pool->snapshot_dirty[b];
+        if (!list->marked[pos])
+        {
+            list->marked[pos] = 1;
+            list->positions[list->count++] = pos;
+        }
+    }
+}
+
+static inline AgentID make_agent_id(AgentIndex index, AgentGeneration gen)
+{
+    return ((AgentID)gen << PATIKA_AGENT_INDEX_BITS) | index;
+}
+static inline AgentIndex agent_index(AgentID id)
 {
-    return id & 0xFFFF;
+    return (AgentIndex)id;
 }
-static inline uint16_t agent_generation(AgentID id)
+static inline AgentGeneration agent_generation(AgentID id)
 {
-    return id >> 16;
+    return (AgentGeneration)(id >> PATIKA_AGENT_INDEX_BITS);
+}
+
+/**
+ * @brief Queue an agent's snapshot entry for rewrite in every buffer
+ * @details agent_set_state and the pool do this themselves; other writes to
+ *          fields the snapshot shows (position, next step, goal) must call it.
+ */
+static inline void agent_mark_dirty(AgentPool *pool, const AgentSlot *agent)
+{
+    agent_mark_position_dirty(pool, pool->active_pos[agent_index(agent->id)]);
 }
 
 struct BarrackSlot
@@ -153,7 +635,7 @@ struct BarrackSlot
     int32_t pos_q, pos_r;
     uint16_t max_agents;
     uint16_t agent_count;
-    uint16_t first_agent_index;
+    AgentIndex first_agent_index;
 };
 
 struct BarrackPool
@@ -182,7 +664,7 @@ struct MapGrid
     MapTile *tiles;
     uint32_t width;
     uint32_t height;
-    AgentID *agent_grid; // why the fuck is it there??
+    uint32_t *agent_grid; // slot index | AGENT_GRID_* flags
 };
 
 void map_init(MapGrid *map, uint8_t type, uint32_t width, uint32_t height);
@@ -194,8 +676,8 @@ void map_set_tile_state(MapGrid *map, int32_t q, int32_t r, uint8_t state);
 uint32_t map_get_agent_grid(MapGrid *map, int32_t q, int32_t r);
 void map_set_agent_grid(MapGrid *map, int32_t q, int32_t r, uint32_t value);
 
-static inline AgentID map_extract_agent_id(uint32_t grid_value) {
-    return grid_value & AGENT_GRID_AGENT_MASK;
+static inline AgentIndex map_extract_agent_id(uint32_t grid_value) {
+    return (AgentIndex)(grid_value & AGENT_GRID_AGENT_MASK);
 }
 
 static inline int map_is_tile_reserved(uint32_t grid_value) {
@@ -203,12 +685,12 @@ static inline int map_is_tile_reserved(uint32_t grid_value) {
 }
 
 static inline int map_is_tile_occupied(uint32_t grid_value) {
-    AgentID id = map_extract_agent_id(grid_value);
-    return id != PATIKA_INVALID_AGENT_ID && !(grid_value & AGENT_GRID_RESERVED_BIT);
+    AgentIndex id = map_extract_agent_id(grid_value);
+    return id != PATIKA_INVALID_AGENT_INDEX && !(grid_value & AGENT_GRID_RESERVED_BIT);
 }
 
 static inline int map_is_tile_empty(uint32_t grid_value) {
-    return map_extract_agent_id(grid_value) == PATIKA_INVALID_AGENT_ID;
+    return map_extract_agent_id(grid_value) == PATIKA_INVALID_AGENT_INDEX;
 }
 struct PCG32
 {
@@ -246,24 +728,97 @@ void clear_tile_reservation(MapGrid *map, int32_t q, int32_t r, AgentID agent_id
 void process_movement(struct PatikaContext *ctx, AgentSlot *agent);
 
 
+/* Per-tick movement deltas, double-buffered like the snapshots */
+typedef struct
+{
+    PatikaMovementDelta *records[2];
+    PatikaMovementDeltas views[2];
+    uint32_t capacity;  // per buffer, one record per agent
+    uint32_t write;     // buffer filled by the running tick
+    _Atomic uint32_t published;
+} MovementDeltas;
+
+void movement_deltas_init(MovementDeltas *d, uint32_t capacity);
+void movement_deltas_destroy(MovementDeltas *d);
+
+/**
+ * @brief Expose the running tick's deltas and start an empty buffer
+ */
+void movement_deltas_publish(MovementDeltas *d, uint64_t tick);
+
+static inline void movement_deltas_record(MovementDeltas *d, const AgentSlot *agent)
+{
+    PatikaMovementDeltas *view = &d->views[d->write];
+    if (view->count < d->capacity)
+    {
+        PatikaMovementDelta *rec = &d->records[d->write][view->count++];
+        rec->agent_index = (uint32_t)agent_index(agent->id);
+        rec->q = (int16_t)agent->pos_q;
+        rec->r = (int16_t)agent->pos_r;
+    }
+}
+
 struct PatikaContext
 {
     PatikaConfig config;
     MPSCCommandQueue cmd_queue;
+    CommandLanes lanes;
+    SubmitWaiters submit_waiters;
+    CommandBatch batch;
+    CommandCoalescer coalescer; // allocated only with config.coalesce_commands
+    TimingWheel wheel;
+    CommandJournal journal; // only with config.journal_path
     SPSCEventQueue event_queue;
+    EventBroadcast broadcast; // only with config.max_event_subscribers
+    EventFilters event_filters;
+    EventOverflow event_overflow;
+    EventWaiters event_waiters;
+    EventRecordRing records; // only with config.event_record_ring_size
+    PayloadPool payloads;
     AgentPool agents;
     BarrackPool barracks;
     MapGrid map;
-    PatikaSnapshot snapshots[2];
-    _Atomic uint32_t snapshot_index;
+    PatikaSnapshot snapshots[PATIKA_SNAPSHOT_BUFFERS];
+    void *snapshot_columns[PATIKA_SNAPSHOT_BUFFERS]; // blocks behind each buffer's columns
+    _Atomic uint32_t snapshot_pins[PATIKA_SNAPSHOT_BUFFERS]; // readers holding each buffer
+    _Atomic uint32_t snapshot_index; // last published buffer
     _Atomic uint64_t version;
+    MovementDeltas deltas; // only with config.movement_deltas
     PCG32 rng;
     PatikaStats stats;
 };
+#define PATIKA_COMMAND_TYPE_COUNT (CMD_SCHEDULE + 1)
+
 void process_command(struct PatikaContext *ctx, const PatikaCommand *cmd);
 
+/**
+ * @brief Process a drained batch, grouped by phase when batch->sorted is set
+ */
+void process_command_batch(struct PatikaContext *ctx, const CommandBatch *batch);
+
+/**
+ * @brief Clear the agent from the map, free its slot and emit EVENT_AGENT_REMOVED
+ */
+void despawn_agent(struct PatikaContext *ctx, AgentSlot *agent);
+
 void compute_next_step(struct PatikaContext *ctx, AgentSlot *agent);
 
+/**
+ * @brief Coalesce and process the commands in ctx->batch
+ */
+void tick_run_commands(struct PatikaContext *ctx);
+
+/**
+ * @brief Agent phases, snapshot and stats that close a tick
+ */
+void tick_finish(struct PatikaContext *ctx);
+
+/**
+ * @brief Carve 64-byte aligned agent columns for a snapshot out of one block
+ * @return The block to free, NULL on allocation failure
+ */
+void *snapshot_columns_alloc(PatikaAgentColumns *columns, uint32_t capacity);
+
 void update_snapshot(struct PatikaContext *ctx);
 
 void compute_patrol(struct PatikaContext *ctx, AgentSlot *agent);
@@ -0,0 +1,157 @@
+#include "internal/patika_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Command coalescing
+ *
+ * Runs over one tick's drained batch before anything is processed and drops
+ * commands that cannot change the outcome:
+ *
+ *  - a SET_GOAL followed by another in-bounds SET_GOAL for the same agent
+ *  - a SET_TILE_STATE followed by another for the same tile, as long as no
+ *    spawn in between reads the tile
+ *  - a SET_GOAL for an agent the batch removes, before or after the remove
+ *  - a repeated REMOVE_AGENT for the same agent
+ *
+ * Agent IDs are only known once an add has been processed, so an add and a
+ * remove of the same agent can never meet in one batch; removes cancel the
+ * goal traffic around them instead.
+ */
+
+void coalescer_init(CommandCoalescer *c, uint32_t agent_count, uint32_t tile_count)
+{
+    memset(c, 0, sizeof(*c));
+    c->agents = calloc(agent_count, sizeof(CoalesceAgentMark));
+    c->tiles = calloc(tile_count, sizeof(uint32_t));
+    if (!c->agents || !c->tiles)
+    {
+        PATIKA_LOG_ERROR("coalescer_init: allocation failed, coalescing disabled");
+        coalescer_destroy(c);
+        return;
+    }
+    c->agent_count = agent_count;
+    c->tile_count = tile_count;
+}
+
+void coalescer_destroy(CommandCoalescer *c)
+{
+    free(c->agents);
+    free(c->tiles);
+    c->agents = NULL;
+    c->tiles = NULL;
+    c->agent_count = 0;
+    c->tile_count = 0;
+}
+
+/* bumps an epoch, clearing the marks on the (very rare) wrap to zero */
+static uint32_t next_epoch(uint32_t *epoch, void *marks, size_t bytes)
+{
+    if (++*epoch == 0)
+    {
+        memset(marks, 0, bytes);
+        *epoch = 1;
+    }
+    return *epoch;
+}
+
+static CoalesceAgentMark *agent_mark(CommandCoalescer *c, AgentID id)
+{
+    AgentIndex index = agent_index(id);
+    return index < c->agent_count ? &c->agents[index] : NULL;
+}
+
+static int is_spawn(CommandType type)
+{
+    return type == CMD_ADD_AGENT || type == CMD_ADD_AGENT_WITH_BEHAVIOR ||
+           type == CMD_ADD_AGENTS_BULK;
+}
+
+uint32_t coalesce_commands(struct PatikaContext *ctx, PatikaCommand *cmds, uint32_t count)
+{
+    CommandCoalescer *c = &ctx->coalescer;
+    if (!c->agents || count < 2)
+        return count;
+
+    uint32_t epoch = next_epoch(&c->agent_epoch, c->agents,
+                                c->agent_count * sizeof(CoalesceAgentMark));
+    uint32_t tile_epoch = next_epoch(&c->tile_epoch, c->tiles,
+                                     c->tile_count * sizeof(uint32_t));
+
+    /* forward: keep the first remove per agent, drop goals after it */
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const PatikaCommand *cmd = &cmds[i];
+        if (cmd->type == CMD_REMOVE_AGENT)
+        {
+            CoalesceAgentMark *m = agent_mark(c, cmd->remove_agent.agent_id);
+            if (m && m->remove_epoch == epoch && m->remove_id == cmd->remove_agent.agent_id)
+                continue;
+            if (m)
+            {
+                m->remove_epoch = epoch;
+                m->remove_id = cmd->remove_agent.agent_id;
+            }
+        }
+        else if (cmd->type == CMD_SET_GOAL)
+        {
+            CoalesceAgentMark *m = agent_mark(c, cmd->set_goal.agent_id);
+            if (m && m->remove_epoch == epoch && m->remove_id == cmd->set_goal.agent_id)
+                continue;
+        }
+        if (kept != i)
+            cmds[kept] = *cmd;
+        kept++;
+    }
+
+    /* backward: keep the last goal per agent and the last state per tile,
+     * survivors are packed towards the end of [0, kept) */
+    uint32_t write = kept;
+    for (uint32_t i = kept; i-- > 0;)
+    {
+        const PatikaCommand *cmd = &cmds[i];
+        if (cmd->type == CMD_SET_GOAL)
+        {
+            AgentID id = cmd->set_goal.agent_id;
+            CoalesceAgentMark *m = agent_mark(c, id);
+            if (m)
+            {
+                if (m->remove_epoch == epoch && m->remove_id == id)
+                    continue; // goal before the agent's remove
+                if (m->goal_epoch == epoch && m->goal_id == id)
+                    continue; // overwritten by a later goal
+                if (map_in_bounds(&ctx->map, cmd->set_goal.goal_q, cmd->set_goal.goal_r))
+                {
+                    m->goal_epoch = epoch;
+                    m->goal_id = id;
+                }
+            }
+        }
+        else if (cmd->type == CMD_SET_TILE_STATE)
+        {
+            MapTile *tile = map_get(&ctx->map, cmd->set_tile.q, cmd->set_tile.r);
+            if (tile)
+            {
+                uint32_t t = (uint32_t)(tile - ctx->map.tiles);
+                if (c->tiles[t] == tile_epoch)
+                    continue;
+                c->tiles[t] = tile_epoch;
+            }
+        }
+        else if (is_spawn(cmd->type))
+        {
+            // spawns read tile state, earlier edits must survive
+            tile_epoch = next_epoch(&c->tile_epoch, c->tiles, c->tile_count * sizeof(uint32_t));
+        }
+        if (--write != i)
+            cmds[write] = *cmd;
+    }
+
+    uint32_t survivors = kept - write;
+    if (write > 0)
+        memmove(cmds, cmds + write, survivors * sizeof(PatikaCommand));
+
+    ctx->stats.commands_coalesced += count - survivors;
+    return survivors;
+}
@@ -63,18 +63,21 @@ int try_reserve_tile(struct PatikaContext *ctx, AgentSlot *agent, int32_t q, int
 
     if (map_is_tile_empty(grid_val))
     {
-        map_set_agent_grid(&ctx->map, q, r, agent->id | AGENT_GRID_RESERVED_BIT);
+        map_set_agent_grid(&ctx->map, q, r, agent_index(agent->id) | AGENT_GRID_RESERVED_BIT);
         return 0;
     }
 
     // Tile has someone (reserved or occupied)
-    AgentID occupant_id = map_extract_agent_id(grid_val);
-    AgentSlot *occupant = agent_pool_get(&ctx->agents, occupant_id);
+    AgentIndex occupant_id = map_extract_agent_id(grid_val);
+    AgentSlot *occupant = agent_pool_slot(&ctx->agents, occupant_id);
 
-    if (!occupant || !occupant->active)
+    // a freed or reused slot, or an agent that has since moved on
+    if (!occupant || occupant == agent ||
+        !((occupant->pos_q == q && occupant->pos_r == r) ||
+          (occupant->next_q == q && occupant->next_r == r)))
     {
         PATIKA_INTERNAL_LOG_WARN("Stale agent_grid entry at (%d,%d), clearing", q, r);
-        map_set_agent_grid(&ctx->map, q, r, agent->id | AGENT_GRID_RESERVED_BIT);
+        map_set_agent_grid(&ctx->map, q, r, agent_index(agent->id) | AGENT_GRID_RESERVED_BIT);
         return 0;
     }
 
@@ -94,8 +97,8 @@ void clear_tile_reservation(MapGrid *map, int32_t q, int32_t r, AgentID agent_id
 {
     uint32_t grid_val = map_get_agent_grid(map, q, r);
 
-    if (map_is_tile_reserved(grid_val) && map_extract_agent_id(grid_val) == agent_id)
+    if (map_is_tile_reserved(grid_val) && map_extract_agent_id(grid_val) == agent_index(agent_id))
     {
-        map_set_agent_grid(map, q, r, PATIKA_INVALID_AGENT_ID);
+        map_set_agent_grid(map, q, r, PATIKA_INVALID_AGENT_INDEX);
     }
 }
@@ -1,342 +1,498 @@
 #include "internal/patika_internal.h"
 #include <stdlib.h>
+#include <string.h>
 
-void process_command(struct PatikaContext *ctx, const PatikaCommand *cmd)
+void despawn_agent(struct PatikaContext *ctx, AgentSlot *agent)
 {
-    switch (cmd->type)
-    {
-    case CMD_ADD_AGENT:
-    {
-        AddAgentPayload *payload = (AddAgentPayload *)cmd->large_command.payload;
+    /* emitted while the slot still holds the agent's tags */
+    PatikaEvent evt = {EVENT_AGENT_REMOVED, agent->id, 0, 0};
+    emit_event(ctx, &evt, agent);
 
-        if (!payload)
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT: NULL payload");
-            return;
-        }
+    /* clear tile so nothing ghosts here */
+    map_set_agent_grid(&ctx->map, agent->pos_q, agent->pos_r, PATIKA_INVALID_AGENT_INDEX);
 
-        if (!map_in_bounds(&ctx->map, payload->start_q, payload->start_r))
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT: position (%d, %d) out of bounds",
-                             payload->start_q, payload->start_r);
-            free(payload);
-            return;
-        }
-
-        MapTile *tile = map_get(&ctx->map, payload->start_q, payload->start_r);
-        if (tile->state != 0)
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT: position (%d, %d) is not walkable",
-                             payload->start_q, payload->start_r);
-            free(payload);
-            return;
-        }
-
-        AgentID id = agent_pool_allocate(&ctx->agents);
-        AgentSlot *agent = agent_pool_get(&ctx->agents, id);
-        if (!agent)
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT: agent pool full");
-            free(payload);
-            return;
-        }
+    agent_pool_free(&ctx->agents, agent->id);
 
-        if (try_reserve_tile(ctx, agent, payload->start_q, payload->start_r) != 0)
-        {
-            agent_pool_free(&ctx->agents, id);
-            PATIKA_LOG_ERROR("ADD_AGENT: tile (%d, %d) is occupied",
-                             payload->start_q, payload->start_r);
-            free(payload);
-            return;
-        }
-
-        agent->pos_q    = payload->start_q;
-        agent->pos_r    = payload->start_r;
-        agent->next_q   = payload->start_q;
-        agent->next_r   = payload->start_r;
-        // no goals here.
-        agent->target_q = payload->start_q;
-        agent->target_r = payload->start_r;
-
-        agent->faction         = payload->faction;
-        agent->side            = payload->side;
-        agent->parent_barrack  = payload->parent_barrack;
-        agent->collision_data  = payload->collision_data;
-
-        agent->behavior = BEHAVIOR_IDLE;
-        agent->state    = STATE_IDLE;
-
-        /* write-back ID if caller requested */
-        if (payload->out_agent_id != NULL)
-        {
-            *payload->out_agent_id = agent->id;
-        }
+    ctx->stats.active_agents--;
+}
 
-        PATIKA_LOG_DEBUG("ADD_AGENT: agent %u spawned at (%d, %d)",
-                         agent->id, agent->pos_q, agent->pos_r);
+/**
+ * @brief Validate a spawn tile, allocate a slot and place an idle agent on it
+ * @return PATIKA_OK, PATIKA_ERR_OUT_OF_BOUNDS, PATIKA_ERR_BUSY (tile blocked
+ *         or occupied) or PATIKA_ERR_CAPACITY (agent pool full)
+ */
+static PatikaError spawn_agent(struct PatikaContext *ctx, int32_t q, int32_t r,
+                               uint8_t faction, uint8_t side, BuildingID parent_barrack,
+                               PatikaCollisionData collision_data, AgentSlot **out_agent)
+{
+    if (!map_in_bounds(&ctx->map, q, r))
+        return PATIKA_ERR_OUT_OF_BOUNDS;
 
-        ctx->stats.commands_processed++;
-        ctx->stats.active_agents++;
-        free(payload);
+    MapTile *tile = map_get(&ctx->map, q, r);
+    if (tile->state != 0)
+        return PATIKA_ERR_BUSY;
+
+    AgentID id = agent_pool_allocate(&ctx->agents);
+    AgentSlot *agent = agent_pool_get(&ctx->agents, id);
+    if (!agent)
+        return PATIKA_ERR_CAPACITY;
+
+    if (try_reserve_tile(ctx, agent, q, r) != 0)
+    {
+        agent_pool_free(&ctx->agents, id);
+        return PATIKA_ERR_BUSY;
+    }
+
+    agent->pos_q    = q;
+    agent->pos_r    = r;
+    agent->next_q   = q;
+    agent->next_r   = r;
+    // no goals here.
+    agent->target_q = q;
+    agent->target_r = r;
+
+    agent->faction         = faction;
+    agent->side            = side;
+    agent->parent_barrack  = parent_barrack;
+    agent->collision_data  = collision_data;
+
+    agent->behavior = BEHAVIOR_IDLE;
+    agent_set_state(&ctx->agents, agent, STATE_IDLE);
+
+    ctx->stats.active_agents++;
+    *out_agent = agent;
+    return PATIKA_OK;
+}
+
+static void log_spawn_error(const char *cmd_name, PatikaError err, int32_t q, int32_t r)
+{
+    switch (err)
+    {
+    case PATIKA_ERR_OUT_OF_BOUNDS:
+        PATIKA_LOG_ERROR("%s: position (%d, %d) out of bounds", cmd_name, q, r);
+        break;
+    case PATIKA_ERR_CAPACITY:
+        PATIKA_LOG_ERROR("%s: agent pool full", cmd_name);
+        break;
+    default:
+        PATIKA_LOG_ERROR("%s: tile (%d, %d) is not walkable or occupied", cmd_name, q, r);
         break;
     }
+}
+
+static void handle_add_agent(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    AddAgentPayload *payload = (AddAgentPayload *)cmd->large_command.payload;
 
-    case CMD_ADD_AGENT_WITH_BEHAVIOR:
+    if (!payload)
     {
-        AddAgentWithBehaviorPayload *payload =
-            (AddAgentWithBehaviorPayload *)cmd->large_command.payload;
+        PATIKA_LOG_ERROR("ADD_AGENT: NULL payload");
+        return;
+    }
 
-        if (!payload)
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: NULL payload");
-            return;
-        }
+    AgentSlot *agent = NULL;
+    PatikaError err = spawn_agent(ctx, payload->start_q, payload->start_r,
+                                  payload->faction, payload->side,
+                                  payload->parent_barrack, payload->collision_data,
+                                  &agent);
+    if (err != PATIKA_OK)
+    {
+        log_spawn_error("ADD_AGENT", err, payload->start_q, payload->start_r);
+        command_release_payload(cmd);
+        return;
+    }
 
-        if (!map_in_bounds(&ctx->map, payload->start_q, payload->start_r))
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: position (%d, %d) out of bounds",
-                             payload->start_q, payload->start_r);
-            free(payload);
-            return;
-        }
-
-        MapTile *tile = map_get(&ctx->map, payload->start_q, payload->start_r);
-        if (tile->state != 0)
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: position (%d, %d) is not walkable",
-                             payload->start_q, payload->start_r);
-            free(payload);
-            return;
-        }
-
-        AgentID id = agent_pool_allocate(&ctx->agents);
-        AgentSlot *agent = agent_pool_get(&ctx->agents, id);
-        if (!agent)
-        {
-            PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: agent pool full");
-            free(payload);
-            return;
-        }
+    /* write-back ID if caller requested */
+    if (payload->out_agent_id != NULL)
+    {
+        *payload->out_agent_id = agent->id;
+    }
 
-        if (try_reserve_tile(ctx, agent, payload->start_q, payload->start_r) != 0)
-        {
-            agent_pool_free(&ctx->agents, id);
-            PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: tile (%d, %d) is occupied",
-                             payload->start_q, payload->start_r);
-            free(payload);
-            return;
-        }
-
-        agent->pos_q    = payload->start_q;
-        agent->pos_r    = payload->start_r;
-        agent->next_q   = payload->start_q;
-        agent->next_r   = payload->start_r;
-        agent->target_q = payload->start_q;
-        agent->target_r = payload->start_r;
-
-        agent->faction        = payload->faction;
-        agent->side           = payload->side;
-        agent->parent_barrack = payload->parent_barrack;
-        agent->collision_data.layer          = payload->collision_data.layer;
-        agent->collision_data.collision_mask = payload->collision_data.collision_mask;
-        agent->collision_data.aggression_mask= payload->collision_data.aggression_mask;
-
-        agent->behavior = payload->initial_behavior;
-
-        switch (payload->initial_behavior)
-        {
-            case BEHAVIOR_IDLE:
-                agent->state = STATE_IDLE;
-                break;
-
-            case BEHAVIOR_PATROL:
-                agent->behavior_data.patrol.center_q      = payload->behavior_params.patrol.center_q;
-                agent->behavior_data.patrol.center_r      = payload->behavior_params.patrol.center_r;
-                agent->behavior_data.patrol.radius        = payload->behavior_params.patrol.radius;
-                agent->behavior_data.patrol.waypoint_index = 0;
-                agent->behavior_data.patrol.idle_timer    = 0.0f;
-                agent->state = STATE_CALCULATING;
-                break;
-
-            case BEHAVIOR_EXPLORE:
-                agent->behavior_data.explore.mode            = payload->behavior_params.explore.mode;
-                agent->behavior_data.explore.cells_visited   = 0;
-                agent->behavior_data.explore.last_target_q   = agent->pos_q;
-                agent->behavior_data.explore.last_target_r   = agent->pos_r;
-                agent->state = STATE_CALCULATING;
-                break;
-
-            case BEHAVIOR_GUARD:
-                PATIKA_LOG_WARN("ADD_AGENT_WITH_BEHAVIOR: GUARD not implemented, falling back to IDLE");
-                agent->behavior = BEHAVIOR_IDLE;
-                agent->state    = STATE_IDLE;
-                break;
-
-            case BEHAVIOR_FLEE:
-                PATIKA_LOG_WARN("ADD_AGENT_WITH_BEHAVIOR: FLEE not implemented, falling back to IDLE");
-                agent->behavior = BEHAVIOR_IDLE;
-                agent->state    = STATE_IDLE;
-                break;
-
-            default:
-                PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: unknown behavior %d, falling back to IDLE",
-                                 (int)payload->initial_behavior);
-                agent->behavior = BEHAVIOR_IDLE;
-                agent->state    = STATE_IDLE;
-                break;
-        }
-
-        /* write-back ID if caller requested */
-        if (payload->out_agent_id != NULL)
-        {
-            *payload->out_agent_id = agent->id;
-        }
+    PATIKA_LOG_DEBUG("ADD_AGENT: agent %" PATIKA_PRI_AGENT_ID " spawned at (%d, %d)",
+                     agent->id, agent->pos_q, agent->pos_r);
 
-        PATIKA_LOG_DEBUG("ADD_AGENT_WITH_BEHAVIOR: agent %u spawned at (%d, %d) behavior=%d",
-                         agent->id, agent->pos_q, agent->pos_r, (int)agent->behavior);
+    ctx->stats.commands_processed++;
+    command_release_payload(cmd);
+}
 
-        ctx->stats.commands_processed++;
-        ctx->stats.active_agents++;
-        free(payload);
-        break;
+static void handle_add_agent_with_behavior(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    AddAgentWithBehaviorPayload *payload =
+        (AddAgentWithBehaviorPayload *)cmd->large_command.payload;
+
+    if (!payload)
+    {
+        PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: NULL payload");
+        return;
     }
 
-    case CMD_REMOVE_AGENT:
+    AgentSlot *agent = NULL;
+    PatikaError err = spawn_agent(ctx, payload->start_q, payload->start_r,
+                                  payload->faction, payload->side,
+                                  payload->parent_barrack, payload->collision_data,
+                                  &agent);
+    if (err != PATIKA_OK)
     {
-        AgentSlot *agent = agent_pool_get(&ctx->agents, cmd->remove_agent.agent_id);
-        if (!agent || !agent->active)
-        {
-            PATIKA_LOG_WARN("REMOVE_AGENT: agent %u not found or already inactive",
-                            cmd->remove_agent.agent_id);
+        log_spawn_error("ADD_AGENT_WITH_BEHAVIOR", err, payload->start_q, payload->start_r);
+        command_release_payload(cmd);
+        return;
+    }
+
+    agent->behavior = payload->initial_behavior;
+
+    switch (payload->initial_behavior)
+    {
+        case BEHAVIOR_IDLE:
+            agent_set_state(&ctx->agents, agent, STATE_IDLE);
             break;
-        }
 
-        /* clear tile so nothing ghosts here */
-        map_set_agent_grid(&ctx->map, agent->pos_q, agent->pos_r, PATIKA_INVALID_AGENT_ID);
+        case BEHAVIOR_PATROL:
+            agent->behavior_data.patrol.center_q      = payload->behavior_params.patrol.center_q;
+            agent->behavior_data.patrol.center_r      = payload->behavior_params.patrol.center_r;
+            agent->behavior_data.patrol.radius        = payload->behavior_params.patrol.radius;
+            agent->behavior_data.patrol.waypoint_index = 0;
+            agent->behavior_data.patrol.idle_timer    = 0.0f;
+            agent_set_state(&ctx->agents, agent, STATE_CALCULATING);
+            break;
 
-        agent_pool_free(&ctx->agents, cmd->remove_agent.agent_id);
+        case BEHAVIOR_EXPLORE:
+            agent->behavior_data.explore.mode            = payload->behavior_params.explore.mode;
+            agent->behavior_data.explore.cells_visited   = 0;
+            agent->behavior_data.explore.last_target_q   = agent->pos_q;
+            agent->behavior_data.explore.last_target_r   = agent->pos_r;
+            agent_set_state(&ctx->agents, agent, STATE_CALCULATING);
+            break;
 
-        PatikaEvent evt = {EVENT_AGENT_REMOVED, cmd->remove_agent.agent_id, 0, 0};
-        spsc_push(&ctx->event_queue, &evt);
+        case BEHAVIOR_GUARD:
+            PATIKA_LOG_WARN("ADD_AGENT_WITH_BEHAVIOR: GUARD not implemented, falling back to IDLE");
+            agent->behavior = BEHAVIOR_IDLE;
+            agent_set_state(&ctx->agents, agent, STATE_IDLE);
+            break;
 
-        ctx->stats.active_agents--;
-        ctx->stats.commands_processed++;
-        break;
+        case BEHAVIOR_FLEE:
+            PATIKA_LOG_WARN("ADD_AGENT_WITH_BEHAVIOR: FLEE not implemented, falling back to IDLE");
+            agent->behavior = BEHAVIOR_IDLE;
+            agent_set_state(&ctx->agents, agent, STATE_IDLE);
+            break;
+
+        default:
+            PATIKA_LOG_ERROR("ADD_AGENT_WITH_BEHAVIOR: unknown behavior %d, falling back to IDLE",
+                             (int)payload->initial_behavior);
+            agent->behavior = BEHAVIOR_IDLE;
+            agent_set_state(&ctx->agents, agent, STATE_IDLE);
+            break;
     }
 
-    case CMD_SET_GOAL:
+    /* write-back ID if caller requested */
+    if (payload->out_agent_id != NULL)
     {
-        AgentSlot *agent = agent_pool_get(&ctx->agents, cmd->set_goal.agent_id);
-        if (!agent || !agent->active)
-        {
-            PATIKA_LOG_WARN("SET_GOAL: agent %u not found", cmd->set_goal.agent_id);
-            break;
-        }
+        *payload->out_agent_id = agent->id;
+    }
 
-        if (!map_in_bounds(&ctx->map, cmd->set_goal.goal_q, cmd->set_goal.goal_r))
-        {
-            PATIKA_LOG_ERROR("SET_GOAL: position (%d, %d) out of bounds",
-                             cmd->set_goal.goal_q, cmd->set_goal.goal_r);
-            break;
-        }
+    PATIKA_LOG_DEBUG("ADD_AGENT_WITH_BEHAVIOR: agent %" PATIKA_PRI_AGENT_ID " spawned at (%d, %d) behavior=%d",
+                     agent->id, agent->pos_q, agent->pos_r, (int)agent->behavior);
 
-        agent->target_q = cmd->set_goal.goal_q;
-        agent->target_r = cmd->set_goal.goal_r;
-        agent->behavior = BEHAVIOR_IDLE;
-        agent->state    = STATE_CALCULATING;
+    ctx->stats.commands_processed++;
+    command_release_payload(cmd);
+}
 
-        PATIKA_LOG_DEBUG("SET_GOAL: agent %u -> (%d, %d)",
-                         agent->id, agent->target_q, agent->target_r);
-        ctx->stats.commands_processed++;
-        break;
+static void handle_add_agents_bulk(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    const PatikaSpawnRecord *records = cmd->add_agents_bulk.records;
+    AgentID *out_ids = cmd->add_agents_bulk.out_agent_ids;
+    PatikaError *out_results = cmd->add_agents_bulk.out_results;
+    uint32_t count = cmd->add_agents_bulk.count;
+
+    if (!records && count > 0)
+    {
+        PATIKA_LOG_ERROR("ADD_AGENTS_BULK: NULL records");
+        return;
     }
 
-    case CMD_SET_TILE_STATE:
+    /* one pass over the wave, failures are reported per record through
+     * out_results instead of being logged */
+    uint32_t spawned = 0;
+    for (uint32_t i = 0; i < count; i++)
     {
-        if (!map_in_bounds(&ctx->map, cmd->set_tile.q, cmd->set_tile.r))
-        {
-            PATIKA_LOG_ERROR("SET_TILE_STATE: (%d, %d) out of bounds",
-                             cmd->set_tile.q, cmd->set_tile.r);
-            break;
-        }
+        const PatikaSpawnRecord *rec = &records[i];
+        AgentSlot *agent = NULL;
+        PatikaError err = spawn_agent(ctx, rec->start_q, rec->start_r,
+                                      rec->faction, rec->side, rec->parent_barrack,
+                                      rec->collision_data, &agent);
+        if (out_ids)
+            out_ids[i] = err == PATIKA_OK ? agent->id : PATIKA_INVALID_AGENT_ID;
+        if (out_results)
+            out_results[i] = err;
+        if (err == PATIKA_OK)
+            spawned++;
+    }
 
-        MapTile *tile = map_get(&ctx->map, cmd->set_tile.q, cmd->set_tile.r);
-        if (tile)
-        {
-            tile->state = cmd->set_tile.state;
-            ctx->stats.commands_processed++;
-        }
-        break;
+    PATIKA_LOG_DEBUG("ADD_AGENTS_BULK: spawned %u of %u agents", spawned, count);
+    ctx->stats.commands_processed++;
+    if (cmd->flags & PATIKA_COMMAND_FLAG_POOLED_PAYLOAD)
+    {
+        payload_pool_release((void *)records);
     }
+}
 
-    case CMD_ADD_BARRACK:
+static void handle_remove_agent(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    AgentSlot *agent = agent_pool_get(&ctx->agents, cmd->remove_agent.agent_id);
+    if (!agent || !agent->active)
     {
-        AddBarrackPayload *payload = (AddBarrackPayload *)cmd->large_command.payload;
+        PATIKA_LOG_WARN("REMOVE_AGENT: agent %" PATIKA_PRI_AGENT_ID " not found or already inactive",
+                        cmd->remove_agent.agent_id);
+        return;
+    }
 
-        if (!payload)
-        {
-            PATIKA_LOG_ERROR("ADD_BARRACK: NULL payload");
-            return;
-        }
+    despawn_agent(ctx, agent);
+    ctx->stats.commands_processed++;
+}
 
-        if (!map_in_bounds(&ctx->map, payload->pos_q, payload->pos_r))
-        {
-            PATIKA_LOG_ERROR("ADD_BARRACK: position (%d, %d) out of bounds",
-                             payload->pos_q, payload->pos_r);
-            free(payload);
-            return;
-        }
-
-        BuildingID id = barrack_pool_allocate(&ctx->barracks);
-        if (id == PATIKA_INVALID_BARRACK_ID)
-        {
-            PATIKA_LOG_ERROR("ADD_BARRACK: barrack pool full");
-            free(payload);
-            return;
-        }
+static void handle_set_goal(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    AgentSlot *agent = agent_pool_get(&ctx->agents, cmd->set_goal.agent_id);
+    if (!agent || !agent->active)
+    {
+        PATIKA_LOG_WARN("SET_GOAL: agent %" PATIKA_PRI_AGENT_ID " not found", cmd->set_goal.agent_id);
+        return;
+    }
 
-        BarrackSlot *barrack = barrack_pool_get(&ctx->barracks, id);
-        if (!barrack)
-        {
-            PATIKA_LOG_ERROR("ADD_BARRACK: allocated ID %u is invalid", (unsigned)id);
-            free(payload);
-            return;
-        }
-
-        barrack->pos_q         = payload->pos_q;
-        barrack->pos_r         = payload->pos_r;
-        barrack->faction       = payload->faction;
-        barrack->side          = payload->side;
-        barrack->patrol_radius = payload->patrol_radius;
-        barrack->max_agents    = payload->max_agents;
-        barrack->behavior      = payload->behavior;
-        barrack->agent_count   = 0;
-
-        /* write-back ID if caller requested */
-        if (payload->out_barrack_id != NULL)
-        {
-            *payload->out_barrack_id = id;
-        }
+    if (!map_in_bounds(&ctx->map, cmd->set_goal.goal_q, cmd->set_goal.goal_r))
+    {
+        PATIKA_LOG_ERROR("SET_GOAL: position (%d, %d) out of bounds",
+                         cmd->set_goal.goal_q, cmd->set_goal.goal_r);
+        return;
+    }
 
-        PATIKA_LOG_DEBUG("ADD_BARRACK: barrack %u at (%d, %d)",
-                         (unsigned)id, barrack->pos_q, barrack->pos_r);
+    agent->target_q = cmd->set_goal.goal_q;
+    agent->target_r = cmd->set_goal.goal_r;
+    agent->behavior = BEHAVIOR_IDLE;
+    agent_mark_dirty(&ctx->agents, agent);
+    agent_set_state(&ctx->agents, agent, STATE_CALCULATING);
+
+    PATIKA_LOG_DEBUG("SET_GOAL: agent %" PATIKA_PRI_AGENT_ID " -> (%d, %d)",
+                     agent->id, agent->target_q, agent->target_r);
+    ctx->stats.commands_processed++;
+}
+
+static void handle_set_tile_state(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    if (!map_in_bounds(&ctx->map, cmd->set_tile.q, cmd->set_tile.r))
+    {
+        PATIKA_LOG_ERROR("SET_TILE_STATE: (%d, %d) out of bounds",
+                         cmd->set_tile.q, cmd->set_tile.r);
+        return;
+    }
 
+    MapTile *tile = map_get(&ctx->map, cmd->set_tile.q, cmd->set_tile.r);
+    if (tile)
+    {
+        tile->state = cmd->set_tile.state;
         ctx->stats.commands_processed++;
-        ctx->stats.active_barracks++;
-        free(payload);
-        break;
     }
+}
+
+static void handle_add_barrack(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    AddBarrackPayload *payload = (AddBarrackPayload *)cmd->large_command.payload;
 
-    case CMD_REMOVE_BARRACK:
+    if (!payload)
     {
-        /* No inline field for barrack_id in the command union yet.
-         * Stubbed — implement once base.h gets a remove_barrack member. */
-        PATIKA_LOG_WARN("REMOVE_BARRACK: not implemented");
-        break;
+        PATIKA_LOG_ERROR("ADD_BARRACK: NULL payload");
+        return;
     }
 
-    default:
-        PATIKA_LOG_WARN("process_command: unhandled command type %d", (int)cmd->type);
-        break;
+    if (!map_in_bounds(&ctx->map, payload->pos_q, payload->pos_r))
+    {
+        PATIKA_LOG_ERROR("ADD_BARRACK: position (%d, %d) out of bounds",
+                         payload->pos_q, payload->pos_r);
+        command_release_payload(cmd);
+        return;
+    }
+
+    BuildingID id = barrack_pool_allocate(&ctx->barracks);
+    if (id == PATIKA_INVALID_BARRACK_ID)
+    {
+        PATIKA_LOG_ERROR("ADD_BARRACK: barrack pool full");
+        command_release_payload(cmd);
+        return;
+    }
+
+    BarrackSlot *barrack = barrack_pool_get(&ctx->barracks, id);
+    if (!barrack)
+    {
+        PATIKA_LOG_ERROR("ADD_BARRACK: allocated ID %u is invalid", (unsigned)id);
+        command_release_payload(cmd);
+        return;
+    }
+
+    barrack->pos_q         = payload->pos_q;
+    barrack->pos_r         = payload->pos_r;
+    barrack->faction       = payload->faction;
+    barrack->side          = payload->side;
+    barrack->patrol_radius = payload->patrol_radius;
+    barrack->max_agents    = payload->max_agents;
+    barrack->behavior      = payload->behavior;
+    barrack->agent_count   = 0;
+
+    /* write-back ID if caller requested */
+    if (payload->out_barrack_id != NULL)
+    {
+        *payload->out_barrack_id = id;
+    }
+
+    PATIKA_LOG_DEBUG("ADD_BARRACK: barrack %u at (%d, %d)",
+                     (unsigned)id, barrack->pos_q, barrack->pos_r);
+
+    ctx->stats.commands_processed++;
+    ctx->stats.active_barracks++;
+    command_release_payload(cmd);
+}
+
+static void handle_remove_barrack(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    /* No inline field for barrack_id in the command union yet.
+     * Stubbed — implement once base.h gets a remove_barrack member. */
+    (void)ctx;
+    (void)cmd;
+    PATIKA_LOG_WARN("REMOVE_BARRACK: not implemented");
+}
+
+static void handle_schedule(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    ScheduledCommand *node = (ScheduledCommand *)cmd->large_command.payload;
+    if (!node)
+    {
+        PATIKA_LOG_ERROR("SCHEDULE: NULL payload");
+        return;
+    }
+    schedule_insert(ctx, node); // counted when the wrapped command runs
+}
+
+static void handle_unhandled(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    (void)ctx;
+    PATIKA_LOG_WARN("process_command: unhandled command type %d", (int)cmd->type);
+    if (command_has_payload(cmd->type))
+    {
+        command_release_payload(cmd);
+    }
+}
+
+typedef void (*CommandHandler)(struct PatikaContext *ctx, const PatikaCommand *cmd);
+
+static const CommandHandler COMMAND_HANDLERS[PATIKA_COMMAND_TYPE_COUNT] = {
+    [CMD_ADD_AGENT]               = handle_add_agent,
+    [CMD_ADD_AGENT_WITH_BEHAVIOR] = handle_add_agent_with_behavior,
+    [CMD_ADD_AGENTS_BULK]         = handle_add_agents_bulk,
+    [CMD_REMOVE_AGENT]            = handle_remove_agent,
+    [CMD_SET_GOAL]                = handle_set_goal,
+    [CMD_SET_TILE_STATE]          = handle_set_tile_state,
+    [CMD_ADD_BARRACK]             = handle_add_barrack,
+    [CMD_REMOVE_BARRACK]          = handle_remove_barrack,
+    [CMD_SCHEDULE]                = handle_schedule,
+};
+
+static inline CommandHandler command_handler(CommandType type)
+{
+    if ((uint32_t)type < PATIKA_COMMAND_TYPE_COUNT && COMMAND_HANDLERS[type])
+        return COMMAND_HANDLERS[type];
+    return handle_unhandled;
+}
+
+/* journal first: handlers release payloads the record is encoded from */
+static inline void dispatch(struct PatikaContext *ctx, CommandHandler handler, const PatikaCommand *cmd)
+{
+    if (journal_active(&ctx->journal) && cmd->type != CMD_SCHEDULE)
+        journal_record(&ctx->journal, cmd);
+    handler(ctx, cmd);
+}
+
+void process_command(struct PatikaContext *ctx, const PatikaCommand *cmd)
+{
+    dispatch(ctx, command_handler(cmd->type), cmd);
+}
+
+/*
+ * Sorted drain order. The map settles first so spawns and goal validation
+ * see this tick's final tiles, removes free slots and tiles before anything
+ * is spawned, and agent control runs once every agent it can name exists.
+ * The sort is stable, so commands within a phase, and therefore all commands
+ * for one entity of that kind, keep their submission order.
+ */
+typedef enum
+{
+    PHASE_MAP,
+    PHASE_REMOVE,
+    PHASE_BARRACKS,
+    PHASE_SPAWN,
+    PHASE_CONTROL,
+    PHASE_OTHER,
+    PHASE_COUNT
+} CommandPhase;
+
+static const uint8_t COMMAND_PHASE[PATIKA_COMMAND_TYPE_COUNT] = {
+    [CMD_ADD_AGENT]                 = PHASE_SPAWN,
+    [CMD_ADD_AGENT_WITH_BEHAVIOR]   = PHASE_SPAWN,
+    [CMD_REMOVE_AGENT]              = PHASE_REMOVE,
+    [CMD_SET_GOAL]                  = PHASE_CONTROL,
+    [CMD_SET_BEHAVIOR]              = PHASE_CONTROL,
+    [CMD_COMPUTE_NEXT]              = PHASE_CONTROL,
+    [CMD_BIND_BARRACK]              = PHASE_CONTROL,
+    [CMD_AGENT_ADD_GUARD_TILE]      = PHASE_CONTROL,
+    [CMD_AGENT_ADD_GUARD_TILES]     = PHASE_CONTROL,
+    [CMD_AGENT_REMOVE_GUARD_TILE]   = PHASE_CONTROL,
+    [CMD_AGENT_CLEAR_GUARD_TILES]   = PHASE_CONTROL,
+    [CMD_ADD_BARRACK]               = PHASE_BARRACKS,
+    [CMD_REMOVE_BARRACK]            = PHASE_BARRACKS,
+    [CMD_BARRACK_ADD_GUARD_TILE]    = PHASE_CONTROL,
+    [CMD_BARRACK_ADD_GUARD_TILES]   = PHASE_CONTROL,
+    [CMD_BARRACK_REMOVE_GUARD_TILE] = PHASE_CONTROL,
+    [CMD_BARRACK_CLEAR_GUARD_TILES] = PHASE_CONTROL,
+    [CMD_ADD_BUILDING]              = PHASE_BARRACKS,
+    [CMD_REMOVE_BUILDING]           = PHASE_BARRACKS,
+    [CMD_SET_TILE_STATE]            = PHASE_MAP,
+    [CMD_DEBUG_DUMP_STATE]          = PHASE_OTHER,
+    [CMD_ADD_AGENTS_BULK]           = PHASE_SPAWN,
+    [CMD_SCHEDULE]                  = PHASE_OTHER,
+};
+
+static inline uint32_t command_phase(CommandType type)
+{
+    return (uint32_t)type < PATIKA_COMMAND_TYPE_COUNT ? COMMAND_PHASE[type] : PHASE_OTHER;
+}
+
+void process_command_batch(struct PatikaContext *ctx, const CommandBatch *batch)
+{
+    if (!batch->sorted)
+    {
+        for (uint32_t i = 0; i < batch->count; i++)
+            process_command(ctx, &batch->cmds[i]);
+        return;
+    }
+
+    /* stable counting sort into phase buckets */
+    uint32_t start[PHASE_COUNT + 1] = {0};
+    for (uint32_t i = 0; i < batch->count; i++)
+        start[command_phase(batch->cmds[i].type) + 1]++;
+    for (uint32_t p = 0; p < PHASE_COUNT; p++)
+        start[p + 1] += start[p];
+
+    uint32_t fill[PHASE_COUNT];
+    memcpy(fill, start, sizeof(fill));
+    for (uint32_t i = 0; i < batch->count; i++)
+        batch->sorted[fill[command_phase(batch->cmds[i].type)]++] = batch->cmds[i];
+
+    /* runs of one type dispatch through a single handler lookup */
+    uint32_t i = 0;
+    while (i < batch->count)
+    {
+        CommandType type = batch->sorted[i].type;
+        CommandHandler handler = command_handler(type);
+        do
+        {
+            dispatch(ctx, handler, &batch->sorted[i++]);
+        } while (i < batch->count && batch->sorted[i].type == type);
     }
 }
@@ -4,7 +4,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-const uint32_t PATIKA_INVALID_AGENT_ID = 0xFFFF;
+const AgentID PATIKA_INVALID_AGENT_ID = PATIKA_INVALID_AGENT_INDEX;
 const uint16_t PATIKA_INVALID_BARRACK_ID = 0xFFFF;
 
 
@@ -19,6 +19,13 @@ PATIKA_API PatikaHandle patika_create(const PatikaConfig *config)
                     config->grid_width,
                     config->grid_height);
 
+    if (config->max_agents == 0 || config->max_agents > PATIKA_MAX_AGENTS)
+    {
+        PATIKA_LOG_ERROR("max_agents %u outside 1..%u for this agent ID layout",
+                         config->max_agents, (uint32_t)PATIKA_MAX_AGENTS);
+        return NULL;
+    }
+
     struct PatikaContext *ctx = calloc(1, sizeof(struct PatikaContext));
     if (!ctx)
     {
@@ -30,17 +37,59 @@ PATIKA_API PatikaHandle patika_create(const PatikaConfig *config)
 
     // Initialize subsystems
     mpsc_init(&ctx->cmd_queue, config->command_queue_size);
+    lanes_init(&ctx->lanes, config->max_producer_lanes,
+               config->lane_queue_size ? config->lane_queue_size : config->command_queue_size);
+
+    ctx->batch.capacity = ctx->cmd_queue.capacity;
+    for (uint32_t l = 0; l < ctx->lanes.max_lanes; l++)
+        ctx->batch.capacity += ctx->lanes.lanes[l].capacity;
+    ctx->batch.cmds = calloc(ctx->batch.capacity, sizeof(PatikaCommand));
+    if (config->sort_commands)
+        ctx->batch.sorted = calloc(ctx->batch.capacity, sizeof(PatikaCommand));
+    ctx->batch.quota = calloc(ctx->lanes.max_lanes + 1, sizeof(uint32_t));
+    ctx->batch.pending = calloc(ctx->lanes.max_lanes + 1, sizeof(uint32_t));
     spsc_init(&ctx->event_queue, config->event_queue_size);
+    broadcast_init(&ctx->broadcast,
+                   config->event_broadcast_size ? config->event_broadcast_size : config->event_queue_size,
+                   config->max_event_subscribers, config->event_overflow_policy);
+    event_filters_init(&ctx->event_filters, ctx->broadcast.max_subs);
+    event_overflow_init(&ctx->event_overflow, config->max_agents, config->coalesce_events);
+    event_waiters_init(&ctx->event_waiters, config->event_notify_fd);
+    record_ring_init(&ctx->records, config->event_record_ring_size);
+    if (config->movement_deltas)
+        movement_deltas_init(&ctx->deltas, config->max_agents);
+    payload_pool_init(&ctx->payloads);
     agent_pool_init(&ctx->agents, config->max_agents);
     barrack_pool_init(&ctx->barracks, config->max_barracks);
     map_init(&ctx->map, config->grid_type, config->grid_width, config->grid_height);
+    if (config->coalesce_commands)
+        coalescer_init(&ctx->coalescer, config->max_agents, ctx->map.width * ctx->map.height);
+    if (config->journal_path && journal_open(&ctx->journal, config->journal_path) != 0)
+    {
+        patika_destroy(ctx);
+        return NULL;
+    }
     pcg32_init(&ctx->rng, config->rng_seed);
 
     // Allocate snapshot buffers
-    ctx->snapshots[0].agents = calloc(config->max_agents, sizeof(AgentSnapshot));
-    ctx->snapshots[1].agents = calloc(config->max_agents, sizeof(AgentSnapshot));
-    ctx->snapshots[0].barracks = calloc(config->max_barracks, sizeof(BarrackSnapshot));
-    ctx->snapshots[1].barracks = calloc(config->max_barracks, sizeof(BarrackSnapshot));
+    for (uint32_t i = 0; i < PATIKA_SNAPSHOT_BUFFERS; i++)
+    {
+        if (config->snapshot_soa)
+            ctx->snapshot_columns[i] = snapshot_columns_alloc(&ctx->snapshots[i].columns, config->max_agents);
+        else
+            ctx->snapshots[i].agents = calloc(config->max_agents, sizeof(AgentSnapshot));
+        ctx->snapshots[i].barracks = calloc(config->max_barracks, sizeof(BarrackSnapshot));
+        atomic_init(&ctx->snapshot_pins[i], 0);
+
+        int agents_ok = config->snapshot_soa ? ctx->snapshot_columns[i] != NULL
+                                             : ctx->snapshots[i].agents != NULL;
+        if (!agents_ok || (config->max_barracks && !ctx->snapshots[i].barracks))
+        {
+            PATIKA_LOG_ERROR("Failed to allocate snapshot buffer %u", i);
+            patika_destroy(ctx);
+            return NULL;
+        }
+    }
 
     atomic_init(&ctx->snapshot_index, 0);
     atomic_init(&ctx->version, 0);
@@ -55,16 +104,33 @@ PATIKA_API void patika_destroy(PatikaHandle handle)
     if (!handle)
         return;
 
+    journal_close(&handle->journal);
+    schedule_destroy(&handle->wheel); // before the payload pool it draws on
     mpsc_destroy(&handle->cmd_queue);
+    lanes_destroy(&handle->lanes);
+    free(handle->batch.cmds);
+    free(handle->batch.sorted);
+    free(handle->batch.quota);
+    free(handle->batch.pending);
+    coalescer_destroy(&handle->coalescer);
     spsc_destroy(&handle->event_queue);
+    broadcast_destroy(&handle->broadcast);
+    event_filters_destroy(&handle->event_filters);
+    event_overflow_destroy(&handle->event_overflow);
+    event_waiters_destroy(&handle->event_waiters);
+    record_ring_destroy(&handle->records);
+    movement_deltas_destroy(&handle->deltas);
+    payload_pool_destroy(&handle->payloads);
     agent_pool_destroy(&handle->agents);
     barrack_pool_destroy(&handle->barracks);
     map_destroy(&handle->map);
 
-    free(handle->snapshots[0].agents);
-    free(handle->snapshots[1].agents);
-    free(handle->snapshots[0].barracks);
-    free(handle->snapshots[1].barracks);
+    for (uint32_t i = 0; i < PATIKA_SNAPSHOT_BUFFERS; i++)
+    {
+        free(handle->snapshots[i].agents);
+        free(handle->snapshot_columns[i]);
+        free(handle->snapshots[i].barracks);
+    }
 
     free(handle);
 }
@@ -93,78 +159,373 @@ PATIKA_API PatikaError patika_submit_command(PatikaHandle handle, const PatikaCo
     return mpsc_push(&handle->cmd_queue, cmd) == 0 ? PATIKA_OK : PATIKA_ERR_QUEUE_FULL;
 }
 
-PATIKA_API PatikaError patika_submit_commands(PatikaHandle handle, const PatikaCommand *cmds, uint32_t count)
+PATIKA_API PatikaError patika_submit_command_wait(PatikaHandle handle, const PatikaCommand *cmd, uint32_t timeout_ms)
 {
     if (!handle)
         return PATIKA_ERR_NULL_HANDLE;
 
-    for (uint32_t i = 0; i < count; i++)
+    if (mpsc_push(&handle->cmd_queue, cmd) == 0)
+        return PATIKA_OK;
+
+    SubmitWaiters *w = &handle->submit_waiters;
+    uint64_t start = patika_now_ns();
+    uint64_t deadline = timeout_ms == PATIKA_WAIT_FOREVER
+                            ? UINT64_MAX
+                            : start + (uint64_t)timeout_ms * 1000000ull;
+    PatikaError result = PATIKA_ERR_TIMEOUT;
+
+    atomic_fetch_add(&w->waiters, 1);
+    for (;;)
     {
-        if (mpsc_push(&handle->cmd_queue, &cmds[i]) != 0)
+        // read the sequence before retrying so a drain in between is not missed
+        uint32_t seq = atomic_load(&w->space_seq);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (mpsc_push(&handle->cmd_queue, cmd) == 0)
         {
-            return PATIKA_ERR_QUEUE_FULL;
+            result = PATIKA_OK;
+            break;
         }
+
+        uint64_t now = patika_now_ns();
+        if (now >= deadline)
+            break;
+        patika_wait_on_address(&w->space_seq, seq, deadline - now);
     }
-    return PATIKA_OK;
+    atomic_fetch_sub(&w->waiters, 1);
+
+    atomic_fetch_add_explicit(&w->wait_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&w->wait_ns, patika_now_ns() - start, memory_order_relaxed);
+    return result;
 }
 
-PATIKA_API void patika_tick(PatikaHandle handle)
+PATIKA_API PatikaError patika_submit_commands(PatikaHandle handle, const PatikaCommand *cmds, uint32_t count)
 {
     if (!handle)
-        return;
+        return PATIKA_ERR_NULL_HANDLE;
 
-    // process all pending commands
-    PatikaCommand cmd;
-    while (mpsc_pop(&handle->cmd_queue, &cmd) == 0)
+    if (patika_submit_batch(handle, cmds, count, PATIKA_SUBMIT_ALL_OR_NOTHING) != count)
     {
-        process_command(handle, &cmd);
+        return PATIKA_ERR_QUEUE_FULL;
     }
+    return PATIKA_OK;
+}
+
+PATIKA_API uint32_t patika_submit_batch(PatikaHandle handle, const PatikaCommand *cmds, uint32_t count, PatikaSubmitMode mode)
+{
+    if (!handle || !cmds || count == 0)
+        return 0;
 
-    for (uint32_t i = 0; i < handle->agents.capacity; i++)
+    MPSCCommandQueue *q = &handle->cmd_queue;
+    if (mode == PATIKA_SUBMIT_ALL_OR_NOTHING && count > q->capacity)
+        return 0;
+
+    uint32_t accepted = 0;
+    while (accepted < count)
     {
-        AgentSlot *agent = &handle->agents.slots[i];
-        if (!agent->active)
-        {
-            continue;
-        }
-        PATIKA_LOG_WARN("AGENT BEHAVIOUR IS : %d",agent->behavior);
-        PATIKA_LOG_WARN("AGENT STATE IS : %d",agent->state);
+        uint32_t want = count - accepted;
+        uint32_t pos;
+        uint32_t got = mpsc_reserve(q, want, mode == PATIKA_SUBMIT_PARTIAL ? 1 : want, &pos);
+        if (got == 0)
+            break;
 
-        if (agent->state == STATE_CALCULATING)
-        { // WAITING_FOR_CALC
-            PATIKA_LOG_WARN("Agent state calculating...");
-            compute_next_step(handle, agent);
+        for (uint32_t i = 0; i < got; i++)
+            *mpsc_slot_command(q, pos + i) = cmds[accepted + i];
+
+        mpsc_publish(q, pos, got);
+        accepted += got;
+    }
+    return accepted;
+}
+
+/* commands waiting in one source: 0 is the shared queue, l + 1 lane l */
+static uint32_t source_depth(struct PatikaContext *ctx, uint32_t source)
+{
+    if (source == 0)
+        return atomic_load_explicit(&ctx->cmd_queue.head, memory_order_relaxed) - ctx->cmd_queue.tail;
+    CommandLane *lane = &ctx->lanes.lanes[source - 1];
+    return atomic_load_explicit(&lane->head, memory_order_relaxed) -
+           atomic_load_explicit(&lane->tail, memory_order_relaxed);
+}
+
+/**
+ * @brief Split limit between the shared queue and the lanes
+ * @details Max-min fair: every source with commands gets an equal share,
+ *          and what a source does not need goes to the others, so a flood
+ *          on one source cannot starve the rest. Slots that do not divide
+ *          evenly go one each to sources in an order that rotates per call.
+ */
+static void split_command_quota(struct PatikaContext *ctx, uint32_t sources, uint32_t limit)
+{
+    CommandBatch *batch = &ctx->batch;
+    uint32_t remaining = limit;
+    uint32_t unsatisfied = 0;
+    for (uint32_t s = 0; s < sources; s++)
+    {
+        batch->pending[s] = source_depth(ctx, s);
+        batch->quota[s] = 0;
+        if (batch->pending[s] > 0)
+            unsatisfied++;
+    }
+
+    while (remaining > 0 && unsatisfied > 0)
+    {
+        uint32_t share = remaining / unsatisfied;
+        if (share == 0)
+        {
+            for (uint32_t n = 0; n < sources && remaining > 0; n++)
+            {
+                uint32_t s = (batch->next_source + n) % sources;
+                if (batch->quota[s] < batch->pending[s])
+                {
+                    batch->quota[s]++;
+                    remaining--;
+                }
+            }
+            break;
         }
-        else if (agent->state == STATE_MOVING)
+        for (uint32_t s = 0; s < sources; s++)
         {
-            PATIKA_LOG_WARN("Agent state moving....");
-            process_movement(handle, agent);
+            uint32_t want = batch->pending[s] - batch->quota[s];
+            if (want == 0)
+                continue;
+            uint32_t give = want < share ? want : share;
+            batch->quota[s] += give;
+            remaining -= give;
+            if (give == want)
+                unsatisfied--;
         }
     }
+    batch->next_source = (batch->next_source + 1) % sources;
+}
 
-    update_snapshot(handle);
+/**
+ * @brief Move up to limit pending commands into the tick batch
+ * @details Shared queue first, then producer lanes in lane id order. When
+ *          more is pending than limit, each source is capped at its fair
+ *          share (split_command_quota).
+ */
+static void drain_commands(struct PatikaContext *ctx, uint32_t limit)
+{
+    CommandBatch *batch = &ctx->batch;
+    batch->count = 0;
+
+    uint32_t lane_count = atomic_load_explicit(&ctx->lanes.registered, memory_order_acquire);
+    uint32_t sources = lane_count + 1;
+    uint32_t depth = 0;
+    for (uint32_t s = 0; s < sources; s++)
+        depth += source_depth(ctx, s);
+    int capped = depth > limit;
+    if (capped)
+        split_command_quota(ctx, sources, limit);
+
+    uint32_t cap = capped ? batch->quota[0] : limit;
+    while (batch->count < cap && mpsc_pop(&ctx->cmd_queue, &batch->cmds[batch->count]) == 0)
+        batch->count++;
+
+    for (uint32_t l = 0; l < lane_count && batch->count < limit; l++)
+    {
+        CommandLane *lane = &ctx->lanes.lanes[l];
+        uint32_t end = capped ? batch->count + batch->quota[l + 1] : limit;
+        while (batch->count < end && lane_pop(lane, &batch->cmds[batch->count]) == 0)
+            batch->count++;
+    }
+}
 
-    handle->stats.total_ticks++;
-    handle->stats.active_agents = handle->agents.active_count;
+/* commands still waiting in the shared queue and the lanes */
+static uint32_t command_backlog(struct PatikaContext *ctx, uint32_t *out_shared)
+{
+    uint32_t shared = source_depth(ctx, 0);
+    uint32_t depth = shared;
+    uint32_t lane_count = atomic_load_explicit(&ctx->lanes.registered, memory_order_acquire);
+    for (uint32_t l = 0; l < lane_count; l++)
+        depth += source_depth(ctx, l + 1);
+    if (out_shared)
+        *out_shared = shared;
+    return depth;
 }
 
-PATIKA_API uint32_t patika_poll_events(PatikaHandle handle, PatikaEvent *out_events, uint32_t max_events)
+// commands processed between clock checks under command_budget_us
+#define COMMAND_BUDGET_CHUNK 256
+
+/**
+ * @brief Process queued commands within the tick's budget
+ * @details Takes at most one batch capacity per tick so producers cannot
+ *          stretch it, less under max_commands_per_tick. With a time budget
+ *          the queue is drained and processed in chunks, and the clock is
+ *          checked between chunks, so a tick overruns by at most one chunk.
+ *          Each chunk is coalesced and phase-sorted on its own. Whatever is
+ *          left stays queued, in order, for the next tick.
+ */
+static void run_queued_commands(struct PatikaContext *ctx)
+{
+    CommandBatch *batch = &ctx->batch;
+    if (!batch->cmds)
+        return;
+
+    uint32_t shared;
+    command_backlog(ctx, &shared);
+    if (shared > ctx->stats.command_queue_high_watermark)
+        ctx->stats.command_queue_high_watermark = shared;
+
+    uint32_t limit = batch->capacity;
+    if (ctx->config.max_commands_per_tick && ctx->config.max_commands_per_tick < limit)
+        limit = ctx->config.max_commands_per_tick;
+    uint64_t budget_ns = (uint64_t)ctx->config.command_budget_us * 1000;
+    uint64_t start = budget_ns ? patika_now_ns() : 0;
+    uint32_t chunk = budget_ns ? COMMAND_BUDGET_CHUNK : limit;
+
+    uint32_t taken = 0;
+    int out_of_budget = 0;
+    while (!out_of_budget)
+    {
+        drain_commands(ctx, chunk < limit - taken ? chunk : limit - taken);
+        if (batch->count == 0)
+            break;
+        taken += batch->count;
+        tick_run_commands(ctx);
+
+        out_of_budget = (taken == limit && limit < batch->capacity) ||
+                        (budget_ns && patika_now_ns() - start >= budget_ns);
+        if (taken == limit)
+            break;
+    }
+
+    // pairs with the fence in patika_submit_command_wait
+    SubmitWaiters *w = &ctx->submit_waiters;
+    atomic_thread_fence(memory_order_seq_cst);
+    if (taken > 0 && atomic_load(&w->waiters) > 0)
+    {
+        atomic_fetch_add(&w->space_seq, 1);
+        patika_wake_address(&w->space_seq);
+    }
+
+    ctx->stats.command_backlog = command_backlog(ctx, NULL);
+    if (ctx->stats.command_backlog == 0)
+    {
+        ctx->stats.command_backlog_ticks = 0;
+        return;
+    }
+    ctx->stats.command_backlog_ticks++;
+    if (out_of_budget)
+        ctx->stats.command_budget_hits++;
+}
+
+void tick_run_commands(struct PatikaContext *ctx)
+{
+    CommandBatch *batch = &ctx->batch;
+    batch->count = coalesce_commands(ctx, batch->cmds, batch->count);
+    process_command_batch(ctx, batch);
+    schedule_run_late(ctx);
+}
+
+void tick_finish(struct PatikaContext *ctx)
+{
+    /* Per-state work lists: idle agents cost nothing. Each phase walks the
+     * entries present when it starts, backwards, so swap-removes only pull
+     * in already visited agents and agents that change state during the
+     * tick are not processed twice. */
+    AgentPool *pool = &ctx->agents;
+    AgentStateList *calculating = &pool->state_lists[STATE_CALCULATING];
+    AgentStateList *moving = &pool->state_lists[STATE_MOVING];
+    AgentStateList *removing = &pool->state_lists[STATE_REMOVE_QUEUE];
+
+    uint32_t moving_count = moving->count;
+    for (uint32_t i = calculating->count; i-- > 0;)
+    {
+        compute_next_step(ctx, &pool->slots[calculating->indices[i]]);
+    }
+
+    for (uint32_t i = moving_count; i-- > 0;)
+    {
+        process_movement(ctx, &pool->slots[moving->indices[i]]);
+    }
+
+    // drained last so the snapshot never shows agents queued for removal
+    for (uint32_t i = removing->count; i-- > 0;)
+    {
+        despawn_agent(ctx, &pool->slots[removing->indices[i]]);
+    }
+
+    movement_deltas_publish(&ctx->deltas, ctx->stats.total_ticks);
+    update_snapshot(ctx);
+
+    // a quiet tick after a burst still tells the consumer it missed events
+    event_flush_overflow(ctx);
+    event_waiters_signal(ctx);
+
+    ctx->stats.total_ticks++;
+    ctx->stats.active_agents = ctx->agents.active_count;
+    ctx->stats.scheduled_commands = ctx->wheel.pending;
+}
+
+PATIKA_API void patika_tick(PatikaHandle handle)
 {
     if (!handle)
+        return;
+
+    journal_begin_tick(&handle->journal, handle->stats.total_ticks);
+    schedule_fire(handle, handle->stats.total_ticks);
+    run_queued_commands(handle);
+    journal_end_tick(&handle->journal);
+
+    tick_finish(handle);
+}
+
+PATIKA_API uint32_t patika_poll_events(PatikaHandle handle, PatikaEvent *out_events, uint32_t max_events)
+{
+    if (!handle || !out_events)
     {
         return 0;
     }
 
-    uint32_t count = 0;
-    while (count < max_events && spsc_pop(&handle->event_queue, &out_events[count]) == 0)
+    uint32_t count = spsc_pop_bulk(&handle->event_queue, out_events, max_events);
+    if (count < max_events)
     {
-        count++;
+        // drained: arm the next signal, then catch anything that raced it
+        event_waiters_arm(&handle->event_waiters);
+        count += spsc_pop_bulk(&handle->event_queue, out_events + count, max_events - count);
     }
-
+    event_release_pending(handle, out_events, count);
     handle->stats.events_emitted += count;
     return count;
 }
 
+PATIKA_API uint32_t patika_peek_events(PatikaHandle handle, uint32_t max_events, PatikaEventSpan *out)
+{
+    if (!handle || !out)
+        return 0;
+
+    SPSCSpan span;
+    uint32_t count = spsc_peek(&handle->event_queue, max_events, &span);
+    if (count == 0)
+    {
+        event_waiters_arm(&handle->event_waiters);
+        count = spsc_peek(&handle->event_queue, max_events, &span);
+    }
+    out->first = span.first;
+    out->first_count = span.first_count;
+    out->second = span.second;
+    out->second_count = span.second_count;
+    return count;
+}
+
+PATIKA_API void patika_commit_events(PatikaHandle handle, uint32_t count)
+{
+    if (!handle)
+        return;
+
+    // never move the tail past head, whatever the caller asks for
+    SPSCSpan span;
+    count = spsc_peek(&handle->event_queue, count, &span);
+    if (handle->event_overflow.pending_slots)
+    {
+        event_release_pending(handle, span.first, span.first_count);
+        event_release_pending(handle, span.second, span.second_count);
+    }
+    spsc_commit(&handle->event_queue, count);
+    handle->stats.events_emitted += count;
+}
+
 PATIKA_API const PatikaSnapshot *patika_get_snapshot(PatikaHandle handle)
 {
     if (!handle)
@@ -174,6 +535,43 @@ PATIKA_API const PatikaSnapshot *patika_get_snapshot(PatikaHandle handle)
     return &handle->snapshots[idx];
 }
 
+PATIKA_API const PatikaSnapshot *patika_acquire_snapshot(PatikaHandle handle)
+{
+    if (!handle)
+        return NULL;
+
+    /* Pin, then confirm the buffer is still the published one. The
+     * simulation thread only writes unpublished buffers it saw unpinned,
+     * so once the check passes it leaves this one alone. */
+    for (;;)
+    {
+        uint32_t idx = atomic_load(&handle->snapshot_index);
+        atomic_fetch_add(&handle->snapshot_pins[idx], 1);
+        if (atomic_load(&handle->snapshot_index) == idx)
+            return &handle->snapshots[idx];
+        atomic_fetch_sub(&handle->snapshot_pins[idx], 1);
+    }
+}
+
+PATIKA_API void patika_release_snapshot(PatikaHandle handle, const PatikaSnapshot *snapshot)
+{
+    if (!handle || !snapshot)
+        return;
+
+    ptrdiff_t idx = snapshot - handle->snapshots;
+    if (idx < 0 || idx >= PATIKA_SNAPSHOT_BUFFERS)
+        return;
+    atomic_fetch_sub(&handle->snapshot_pins[idx], 1);
+}
+
+PATIKA_API const PatikaMovementDeltas *patika_get_movement_deltas(PatikaHandle handle)
+{
+    if (!handle || !handle->deltas.capacity)
+        return NULL;
+
+    return &handle->deltas.views[atomic_load(&handle->deltas.published)];
+}
+
 PATIKA_API PatikaStats patika_get_stats(PatikaHandle handle)
 {
     if (!handle)
@@ -181,7 +579,10 @@ PATIKA_API PatikaStats patika_get_stats(PatikaHandle handle)
         PatikaStats empty = {0};
         return empty;
     }
-    return handle->stats;
+    PatikaStats stats = handle->stats;
+    stats.submit_waits = atomic_load_explicit(&handle->submit_waiters.wait_count, memory_order_relaxed);
+    stats.submit_wait_ns = atomic_load_explicit(&handle->submit_waiters.wait_ns, memory_order_relaxed);
+    return stats;
 }
 
 
@@ -0,0 +1,628 @@
+#include "internal/patika_internal.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Broadcast event ring.
+ *
+ * The simulation thread is the only producer; every subscriber owns a cursor
+ * and reads the ring in place. Positions are 64-bit and never wrap, so a
+ * cursor's distance to head is its backlog. Under the overwriting policies
+ * the producer never looks at cursors: a reader checks head after reading
+ * and treats anything the producer may have reached as lost. The slot the
+ * producer writes next is never handed out, so capacity - 1 events are
+ * readable. Under PATIKA_OVERFLOW_BLOCK the producer parks instead until
+ * the slowest cursor frees a slot.
+ *
+ * emit_event checks the event queue's and subscribers' filters before any
+ * push, so an event nobody wants costs a mask test and never takes a slot.
+ * The ring holds the union of what its subscribers want.
+ *
+ * Events the queue has no room for are counted per type and owed to the
+ * consumer as one EVENT_OVERFLOW record, queued as soon as a slot frees up
+ * and ahead of any later event.
+ *
+ * Consumers that find the queue empty arm a signal. The simulation thread
+ * checks it once, at the end of a tick, so a busy consumer costs nothing
+ * and a sleeping one is woken at most once per tick.
+ */
+
+#define FILTER_ALL 0xFFFFFFFFu
+#define BROADCAST_WAIT_NS 1000000ull // re-check cursors at least this often
+
+static uint32_t broadcast_round_up_pow2(uint32_t v) {
+  uint32_t p = 2;
+  while (p < v && p < 0x80000000u)
+    p <<= 1;
+  return p;
+}
+
+void broadcast_init(EventBroadcast *b, uint32_t capacity, uint32_t max_subs,
+                    uint8_t policy) {
+  b->slots = NULL;
+  b->subs = NULL;
+  b->capacity = 0;
+  b->max_subs = 0;
+  b->policy = policy;
+  b->min_cursor = 0;
+  atomic_init(&b->head, 0);
+  atomic_init(&b->space_seq, 0);
+  atomic_init(&b->producer_waiting, 0);
+  if (max_subs == 0) {
+    return;
+  }
+
+  capacity = broadcast_round_up_pow2(capacity);
+  b->slots = (PatikaEvent *)calloc(capacity, sizeof(PatikaEvent));
+  b->subs = (EventSubscriber *)calloc(max_subs, sizeof(EventSubscriber));
+  if (!b->slots || !b->subs) {
+    broadcast_destroy(b);
+    return;
+  }
+  for (uint32_t i = 0; i < max_subs; i++) {
+    atomic_init(&b->subs[i].cursor, 0);
+    atomic_init(&b->subs[i].delivered, 0);
+    atomic_init(&b->subs[i].dropped, 0);
+    atomic_init(&b->subs[i].state, SUBSCRIBER_FREE);
+  }
+  b->capacity = capacity;
+  b->mask = capacity - 1;
+  b->max_subs = max_subs;
+}
+
+void broadcast_destroy(EventBroadcast *b) {
+  free(b->slots);
+  free(b->subs);
+  b->slots = NULL;
+  b->subs = NULL;
+  b->capacity = 0;
+  b->max_subs = 0;
+}
+
+static uint64_t broadcast_min_cursor(EventBroadcast *b, uint64_t head) {
+  // pairs with the fences in broadcast_wake_producer and
+  // patika_subscribe_events
+  atomic_thread_fence(memory_order_seq_cst);
+  uint64_t min = head;
+  for (uint32_t i = 0; i < b->max_subs; i++) {
+    EventSubscriber *s = &b->subs[i];
+    if (atomic_load_explicit(&s->state, memory_order_acquire) !=
+        SUBSCRIBER_ACTIVE) {
+      continue;
+    }
+    uint64_t cursor = atomic_load_explicit(&s->cursor, memory_order_acquire);
+    if (cursor < min) {
+      min = cursor;
+    }
+  }
+  return min;
+}
+
+/* blocks until the slowest subscriber leaves a free slot */
+static void broadcast_wait_for_space(EventBroadcast *b, uint64_t head) {
+  b->min_cursor = broadcast_min_cursor(b, head);
+  while (head - b->min_cursor >= b->capacity) {
+    uint32_t seq = atomic_load(&b->space_seq);
+    atomic_store(&b->producer_waiting, 1);
+    b->min_cursor = broadcast_min_cursor(b, head);
+    if (head - b->min_cursor < b->capacity) {
+      break;
+    }
+    patika_wait_on_address(&b->space_seq, seq, BROADCAST_WAIT_NS);
+    b->min_cursor = broadcast_min_cursor(b, head);
+  }
+  atomic_store_explicit(&b->producer_waiting, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Publishes an event to every subscriber (simulation thread only).
+ */
+void broadcast_publish(EventBroadcast *b, const PatikaEvent *evt) {
+  uint64_t head = atomic_load_explicit(&b->head, memory_order_relaxed);
+  if (b->policy == PATIKA_OVERFLOW_BLOCK &&
+      head - b->min_cursor >= b->capacity) {
+    broadcast_wait_for_space(b, head);
+  }
+
+  b->slots[head & b->mask] = *evt;
+  atomic_store_explicit(&b->head, head + 1, memory_order_release);
+}
+
+static EventSubscriber *subscriber_for_cursor(PatikaHandle handle,
+                                              PatikaEventCursor cursor) {
+  if (!handle || cursor >= handle->broadcast.max_subs) {
+    return NULL;
+  }
+  EventSubscriber *s = &handle->broadcast.subs[cursor];
+  if (atomic_load_explicit(&s->state, memory_order_acquire) !=
+      SUBSCRIBER_ACTIVE) {
+    return NULL;
+  }
+  return s;
+}
+
+/* NULL accepts every event */
+static void filter_slot_store(EventFilterSlot *slot,
+                              const PatikaEventFilter *filter) {
+  atomic_store_explicit(&slot->type_mask, filter ? filter->type_mask : FILTER_ALL,
+                        memory_order_relaxed);
+  atomic_store_explicit(&slot->side_mask, filter ? filter->side_mask : FILTER_ALL,
+                        memory_order_relaxed);
+  atomic_store_explicit(&slot->faction_mask,
+                        filter ? filter->faction_mask : FILTER_ALL,
+                        memory_order_relaxed);
+}
+
+static PatikaEventFilter filter_slot_load(EventFilterSlot *slot) {
+  PatikaEventFilter f;
+  f.type_mask = atomic_load_explicit(&slot->type_mask, memory_order_relaxed);
+  f.side_mask = atomic_load_explicit(&slot->side_mask, memory_order_relaxed);
+  f.faction_mask =
+      atomic_load_explicit(&slot->faction_mask, memory_order_relaxed);
+  return f;
+}
+
+void event_filters_init(EventFilters *f, uint32_t max_subs) {
+  filter_slot_store(&f->queue, NULL);
+  atomic_init(&f->seq, 1); // seen_seq 0 forces a rebuild on the first event
+  f->seen_seq = 0;
+  f->type_union = 0;
+  f->subs_count = 0;
+  f->subs_copy = max_subs ? (PatikaEventFilter *)calloc(
+                                max_subs, sizeof(PatikaEventFilter))
+                          : NULL;
+}
+
+void event_filters_destroy(EventFilters *f) {
+  free(f->subs_copy);
+  f->subs_copy = NULL;
+}
+
+/* simulation thread: snapshot every sink's filter */
+static void event_filters_rebuild(struct PatikaContext *ctx) {
+  EventFilters *f = &ctx->event_filters;
+  EventBroadcast *b = &ctx->broadcast;
+  f->seen_seq = atomic_load_explicit(&f->seq, memory_order_acquire);
+  f->type_union = 0;
+  f->subs_count = 0;
+
+  if (ctx->event_queue.capacity) {
+    f->queue_copy = filter_slot_load(&f->queue);
+    f->type_union |= f->queue_copy.type_mask;
+  } else {
+    memset(&f->queue_copy, 0, sizeof(f->queue_copy));
+  }
+
+  for (uint32_t i = 0; i < b->max_subs && f->subs_copy; i++) {
+    EventSubscriber *s = &b->subs[i];
+    if (atomic_load_explicit(&s->state, memory_order_acquire) !=
+        SUBSCRIBER_ACTIVE) {
+      continue;
+    }
+    PatikaEventFilter copy = filter_slot_load(&s->filter);
+    f->subs_copy[f->subs_count++] = copy;
+    f->type_union |= copy.type_mask;
+  }
+}
+
+static inline int filter_accepts(const PatikaEventFilter *f, uint32_t type_bit,
+                                 uint32_t side_bit, uint32_t faction_bit) {
+  return (f->type_mask & type_bit) && (f->side_mask & side_bit) &&
+         (f->faction_mask & faction_bit);
+}
+
+PATIKA_API void patika_set_event_filter(PatikaHandle handle,
+                                        const PatikaEventFilter *filter) {
+  if (!handle) {
+    return;
+  }
+  filter_slot_store(&handle->event_filters.queue, filter);
+  atomic_fetch_add_explicit(&handle->event_filters.seq, 1,
+                            memory_order_release);
+}
+
+PATIKA_API PatikaEventCursor patika_subscribe_events(PatikaHandle handle) {
+  if (!handle) {
+    return PATIKA_INVALID_EVENT_CURSOR;
+  }
+  EventBroadcast *b = &handle->broadcast;
+  for (uint32_t i = 0; i < b->max_subs; i++) {
+    EventSubscriber *s = &b->subs[i];
+    uint32_t expected = SUBSCRIBER_FREE;
+    if (!atomic_compare_exchange_strong(&s->state, &expected,
+                                        SUBSCRIBER_CLAIMED)) {
+      continue;
+    }
+    // a producer scan that ran before ACTIVE was visible may have cached a
+    // min_cursor past this head, so the cursor is re-read once it is
+    atomic_store_explicit(
+        &s->cursor, atomic_load_explicit(&b->head, memory_order_acquire),
+        memory_order_relaxed);
+    atomic_store_explicit(&s->delivered, 0, memory_order_relaxed);
+    atomic_store_explicit(&s->dropped, 0, memory_order_relaxed);
+    filter_slot_store(&s->filter, NULL);
+    atomic_store_explicit(&s->state, SUBSCRIBER_ACTIVE, memory_order_release);
+    // pairs with the fence in broadcast_min_cursor: either that scan sees
+    // ACTIVE, or this load sees the head it scanned against
+    atomic_thread_fence(memory_order_seq_cst);
+    atomic_store_explicit(
+        &s->cursor, atomic_load_explicit(&b->head, memory_order_acquire),
+        memory_order_release);
+    atomic_fetch_add_explicit(&handle->event_filters.seq, 1,
+                              memory_order_release);
+    return i;
+  }
+  return PATIKA_INVALID_EVENT_CURSOR;
+}
+
+static void broadcast_wake_producer(EventBroadcast *b) {
+  // pairs with the fence in broadcast_min_cursor
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load(&b->producer_waiting)) {
+    atomic_fetch_add(&b->space_seq, 1);
+    patika_wake_address(&b->space_seq);
+  }
+}
+
+PATIKA_API void patika_unsubscribe_events(PatikaHandle handle,
+                                          PatikaEventCursor cursor) {
+  EventSubscriber *s = subscriber_for_cursor(handle, cursor);
+  if (!s) {
+    return;
+  }
+  atomic_store_explicit(&s->state, SUBSCRIBER_FREE, memory_order_release);
+  atomic_fetch_add_explicit(&handle->event_filters.seq, 1,
+                            memory_order_release);
+  broadcast_wake_producer(&handle->broadcast);
+}
+
+PATIKA_API PatikaError patika_cursor_peek_events(PatikaHandle handle,
+                                                 PatikaEventCursor cursor,
+                                                 uint32_t max_events,
+                                                 PatikaEventSpan *out) {
+  if (!handle || !out) {
+    return PATIKA_ERR_NULL_HANDLE;
+  }
+  out->first = NULL;
+  out->first_count = 0;
+  out->second = NULL;
+  out->second_count = 0;
+
+  EventSubscriber *s = subscriber_for_cursor(handle, cursor);
+  if (!s) {
+    return PATIKA_ERR_INVALID_ID;
+  }
+  EventBroadcast *b = &handle->broadcast;
+  uint64_t pos = atomic_load_explicit(&s->cursor, memory_order_relaxed);
+  uint64_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+
+  if (b->policy != PATIKA_OVERFLOW_BLOCK && head - pos >= b->capacity) {
+    uint64_t oldest = head - (b->capacity - 1);
+    atomic_fetch_add_explicit(&s->dropped, oldest - pos, memory_order_relaxed);
+    atomic_store_explicit(&s->cursor, oldest, memory_order_relaxed);
+    pos = oldest;
+    if (b->policy == PATIKA_OVERFLOW_LAG) {
+      return PATIKA_ERR_LAGGED;
+    }
+  }
+
+  uint64_t available = head - pos;
+  uint32_t count = available < max_events ? (uint32_t)available : max_events;
+  uint32_t start = (uint32_t)(pos & b->mask);
+  uint32_t first = b->capacity - start;
+  if (first > count) {
+    first = count;
+  }
+
+  out->first = &b->slots[start];
+  out->first_count = first;
+  out->second = b->slots;
+  out->second_count = count - first;
+  return PATIKA_OK;
+}
+
+PATIKA_API PatikaError patika_cursor_commit_events(PatikaHandle handle,
+                                                   PatikaEventCursor cursor,
+                                                   uint32_t count) {
+  if (!handle) {
+    return PATIKA_ERR_NULL_HANDLE;
+  }
+  EventSubscriber *s = subscriber_for_cursor(handle, cursor);
+  if (!s) {
+    return PATIKA_ERR_INVALID_ID;
+  }
+  EventBroadcast *b = &handle->broadcast;
+  uint64_t pos = atomic_load_explicit(&s->cursor, memory_order_relaxed);
+
+  // the reads of the peeked slots happen before this load of head
+  atomic_thread_fence(memory_order_acquire);
+  uint64_t head = atomic_load_explicit(&b->head, memory_order_relaxed);
+  if (count > head - pos) {
+    return PATIKA_ERR_OUT_OF_BOUNDS;
+  }
+
+  uint64_t lost = 0;
+  if (b->policy != PATIKA_OVERFLOW_BLOCK && head - pos >= b->capacity) {
+    lost = head - (b->capacity - 1) - pos;
+    if (lost > count) {
+      lost = count;
+    }
+  }
+
+  atomic_store_explicit(&s->cursor, pos + count, memory_order_release);
+  atomic_fetch_add_explicit(&s->delivered, count - lost, memory_order_relaxed);
+  if (lost) {
+    atomic_fetch_add_explicit(&s->dropped, lost, memory_order_relaxed);
+    return PATIKA_ERR_LAGGED;
+  }
+  if (b->policy == PATIKA_OVERFLOW_BLOCK) {
+    broadcast_wake_producer(b);
+  }
+  return PATIKA_OK;
+}
+
+PATIKA_API PatikaError patika_set_cursor_filter(
+    PatikaHandle handle, PatikaEventCursor cursor,
+    const PatikaEventFilter *filter) {
+  if (!handle) {
+    return PATIKA_ERR_NULL_HANDLE;
+  }
+  EventSubscriber *s = subscriber_for_cursor(handle, cursor);
+  if (!s) {
+    return PATIKA_ERR_INVALID_ID;
+  }
+  filter_slot_store(&s->filter, filter);
+  atomic_fetch_add_explicit(&handle->event_filters.seq, 1,
+                            memory_order_release);
+  return PATIKA_OK;
+}
+
+PATIKA_API PatikaError patika_get_cursor_stats(PatikaHandle handle,
+                                               PatikaEventCursor cursor,
+                                               PatikaCursorStats *out) {
+  if (!handle || !out) {
+    return PATIKA_ERR_NULL_HANDLE;
+  }
+  EventSubscriber *s = subscriber_for_cursor(handle, cursor);
+  if (!s) {
+    return PATIKA_ERR_INVALID_ID;
+  }
+  out->delivered = atomic_load_explicit(&s->delivered, memory_order_relaxed);
+  out->dropped = atomic_load_explicit(&s->dropped, memory_order_relaxed);
+  out->pending = atomic_load_explicit(&handle->broadcast.head,
+                                      memory_order_relaxed) -
+                 atomic_load_explicit(&s->cursor, memory_order_relaxed);
+  return PATIKA_OK;
+}
+
+void event_overflow_init(EventOverflow *o, uint32_t max_agents, int coalesce) {
+  o->pending_drops = 0;
+  o->pending = NULL;
+  o->pending_slots = 0;
+  if (!coalesce) {
+    return;
+  }
+  o->pending = (_Atomic uint64_t *)calloc(max_agents, sizeof(*o->pending));
+  if (o->pending) {
+    o->pending_slots = max_agents;
+  }
+}
+
+void event_overflow_destroy(EventOverflow *o) {
+  free((void *)o->pending);
+  o->pending = NULL;
+  o->pending_slots = 0;
+}
+
+int event_flush_overflow(struct PatikaContext *ctx) {
+  EventOverflow *o = &ctx->event_overflow;
+  if (o->pending_drops == 0) {
+    return 1;
+  }
+  PatikaEvent evt = {EVENT_OVERFLOW, PATIKA_INVALID_AGENT_ID,
+                     o->pending_drops < INT32_MAX ? (int32_t)o->pending_drops
+                                                  : INT32_MAX,
+                     0};
+  if (spsc_push(&ctx->event_queue, &evt) != PATIKA_OK) {
+    return 0;
+  }
+  o->pending_drops = 0;
+  return 1;
+}
+
+/* Pending bits are tagged with the agent's generation: a slot reused by a
+ * new agent starts clean even while the old agent's events are queued. */
+#define PENDING_TYPE_BITS 0xFFu
+
+static inline _Atomic uint64_t *event_pending_slot(EventOverflow *o,
+                                                   AgentID id) {
+  AgentIndex index = agent_index(id);
+  return index < o->pending_slots ? &o->pending[index] : NULL;
+}
+
+void event_release_pending(struct PatikaContext *ctx, const PatikaEvent *events,
+                           uint32_t count) {
+  EventOverflow *o = &ctx->event_overflow;
+  if (!o->pending_slots) {
+    return;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    _Atomic uint64_t *slot = event_pending_slot(o, events[i].agent_id);
+    if (!slot) {
+      continue;
+    }
+    uint64_t tag = (uint64_t)agent_generation(events[i].agent_id) << 8;
+    uint64_t v = atomic_load_explicit(slot, memory_order_relaxed);
+    while ((v & ~(uint64_t)PENDING_TYPE_BITS) == tag &&
+           !atomic_compare_exchange_weak_explicit(
+               slot, &v, v & ~(uint64_t)(1u << events[i].type),
+               memory_order_relaxed, memory_order_relaxed)) {
+    }
+  }
+}
+
+/* Marks type pending for the agent; returns 0 if it already was. Marked
+ * before the push, so the consumer's release can never be overtaken. */
+static int event_mark_pending(_Atomic uint64_t *slot, AgentID id,
+                              uint32_t type) {
+  uint64_t tag = (uint64_t)agent_generation(id) << 8;
+  uint64_t bit = 1u << type;
+  uint64_t v = atomic_load_explicit(slot, memory_order_relaxed);
+  for (;;) {
+    uint64_t next = (v & ~(uint64_t)PENDING_TYPE_BITS) == tag ? v | bit
+                                                              : tag | bit;
+    if (next == v) {
+      return 0;
+    }
+    if (atomic_compare_exchange_weak_explicit(slot, &v, next,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed)) {
+      return 1;
+    }
+  }
+}
+
+static void event_queue_push(struct PatikaContext *ctx,
+                             const PatikaEvent *evt) {
+  EventOverflow *o = &ctx->event_overflow;
+  _Atomic uint64_t *slot =
+      o->pending_slots ? event_pending_slot(o, evt->agent_id) : NULL;
+  if (slot && !event_mark_pending(slot, evt->agent_id, evt->type)) {
+    ctx->stats.events_coalesced++;
+    return;
+  }
+
+  // the overflow record keeps its place ahead of anything emitted after the gap
+  if (!event_flush_overflow(ctx) ||
+      spsc_push(&ctx->event_queue, evt) != PATIKA_OK) {
+    if (slot) {
+      event_release_pending(ctx, evt, 1);
+    }
+    ctx->stats.events_dropped[evt->type]++;
+    o->pending_drops++;
+  }
+}
+
+void event_waiters_init(EventWaiters *w, int want_fd) {
+  atomic_init(&w->seq, 0);
+  atomic_init(&w->waiters, 0);
+  atomic_init(&w->armed, 1); // nobody has seen an event yet
+  w->fd = want_fd ? patika_eventfd_create() : -1;
+  if (want_fd && w->fd < 0) {
+    PATIKA_LOG_WARN("event notification fd unavailable, use patika_wait_events");
+  }
+}
+
+void event_waiters_destroy(EventWaiters *w) {
+  if (w->fd >= 0) {
+    patika_eventfd_close(w->fd);
+  }
+  w->fd = -1;
+}
+
+void event_waiters_arm(EventWaiters *w) {
+  atomic_store(&w->armed, 1);
+  // pairs with the fence in event_waiters_signal
+  atomic_thread_fence(memory_order_seq_cst);
+}
+
+static int event_queue_empty(SPSCEventQueue *q) {
+  return atomic_load_explicit(&q->head, memory_order_acquire) ==
+         atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+void event_waiters_signal(struct PatikaContext *ctx) {
+  EventWaiters *w = &ctx->event_waiters;
+  atomic_thread_fence(memory_order_seq_cst);
+  if (event_queue_empty(&ctx->event_queue) || !atomic_load(&w->armed) ||
+      !atomic_exchange(&w->armed, 0)) {
+    return;
+  }
+
+  atomic_fetch_add(&w->seq, 1);
+  if (atomic_load(&w->waiters) > 0) {
+    patika_wake_address(&w->seq);
+  }
+  if (w->fd >= 0) {
+    patika_eventfd_signal(w->fd);
+  }
+  ctx->stats.event_wakeups++;
+}
+
+PATIKA_API PatikaError patika_wait_events(PatikaHandle handle,
+                                          uint32_t timeout_ms) {
+  if (!handle) {
+    return PATIKA_ERR_NULL_HANDLE;
+  }
+  if (!event_queue_empty(&handle->event_queue)) {
+    return PATIKA_OK;
+  }
+
+  EventWaiters *w = &handle->event_waiters;
+  uint64_t deadline = timeout_ms == PATIKA_WAIT_FOREVER
+                          ? UINT64_MAX
+                          : patika_now_ns() + (uint64_t)timeout_ms * 1000000ull;
+  PatikaError result = PATIKA_ERR_TIMEOUT;
+
+  atomic_fetch_add(&w->waiters, 1);
+  for (;;) {
+    // read the sequence before re-checking so a signal in between is not missed
+    uint32_t seq = atomic_load(&w->seq);
+    event_waiters_arm(w);
+    if (!event_queue_empty(&handle->event_queue)) {
+      result = PATIKA_OK;
+      break;
+    }
+
+    uint64_t now = patika_now_ns();
+    if (now >= deadline) {
+      break;
+    }
+    patika_wait_on_address(&w->seq, seq, deadline - now);
+  }
+  atomic_fetch_sub(&w->waiters, 1);
+  return result;
+}
+
+PATIKA_API int patika_get_event_fd(PatikaHandle handle) {
+  return handle ? handle->event_waiters.fd : -1;
+}
+
+void emit_event(struct PatikaContext *ctx, const PatikaEvent *evt,
+                const AgentSlot *agent) {
+  if (ctx->records.capacity) {
+    PatikaAgentRecord rec = {evt->agent_id, evt->pos_q, evt->pos_r,
+                             agent->parent_barrack, agent->side, agent->faction};
+    emit_record(ctx, (uint16_t)evt->type, &rec, sizeof(rec));
+  }
+
+  EventFilters *f = &ctx->event_filters;
+  if (atomic_load_explicit(&f->seq, memory_order_relaxed) != f->seen_seq) {
+    event_filters_rebuild(ctx);
+  }
+
+  uint32_t type_bit = PATIKA_EVENT_BIT(evt->type);
+  if (!(f->type_union & type_bit)) {
+    ctx->stats.events_filtered++;
+    return;
+  }
+  uint32_t side_bit = PATIKA_EVENT_BIT(agent->side);
+  uint32_t faction_bit = PATIKA_EVENT_BIT(agent->faction);
+
+  int accepted = 0;
+  if (filter_accepts(&f->queue_copy, type_bit, side_bit, faction_bit)) {
+    event_queue_push(ctx, evt);
+    accepted = 1;
+  }
+  for (uint32_t i = 0; i < f->subs_count; i++) {
+    if (filter_accepts(&f->subs_copy[i], type_bit, side_bit, faction_bit)) {
+      broadcast_publish(&ctx->broadcast, evt);
+      accepted = 1;
+      break;
+    }
+  }
+  if (!accepted) {
+    ctx->stats.events_filtered++;
+  }
+}
@@ -0,0 +1,276 @@
+#include "internal/patika_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Command journal
+ *
+ * File layout, little-endian:
+ *
+ *   header (32)   stream header (8), u32 "PTKJ", u32 reserved,
+ *                 u64 tick count, u64 index offset (both 0 until closed)
+ *   per tick      u64 tick, u32 record count, u32 body bytes, stream records
+ *   index         u64 block offset per tick
+ *
+ * Every tick gets a block, empty or not, so replay advances the simulation
+ * exactly as often as the recording did. Records are the commands as they
+ * were executed: after coalescing and sorting, with scheduled commands at
+ * the tick they fired. A journal whose writer died without closing has no
+ * index, and replay then walks the blocks in order.
+ */
+
+#define JOURNAL_MAGIC 0x4A4B5450u /* "PTKJ" */
+#define JOURNAL_HEADER_SIZE 32
+#define JOURNAL_BLOCK_HEADER_SIZE 16
+#define JOURNAL_INITIAL_SIZE (1u << 20)
+
+static inline uint32_t rd_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t rd_u64(const uint8_t *p)
+{
+    return (uint64_t)rd_u32(p) | ((uint64_t)rd_u32(p + 4) << 32);
+}
+
+static inline void wr_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void wr_u64(uint8_t *p, uint64_t v)
+{
+    wr_u32(p, (uint32_t)v);
+    wr_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+/* unmaps and trims to what was written, recording stops */
+static void journal_release(CommandJournal *j)
+{
+    mapped_file_close(&j->file, j->used);
+    free(j->index);
+    memset(j, 0, sizeof(*j));
+}
+
+/* make room for bytes more, doubling the mapping; on failure the journal
+ * is released so the simulation keeps running unrecorded */
+static int journal_reserve(CommandJournal *j, size_t bytes)
+{
+    if (j->used + bytes <= j->file.size)
+        return 0;
+
+    size_t size = j->file.size;
+    while (j->used + bytes > size)
+        size *= 2;
+    if (mapped_file_resize(&j->file, size) != 0)
+    {
+        PATIKA_LOG_ERROR("journal: could not grow to %zu bytes, recording stopped", size);
+        journal_release(j);
+        return -1;
+    }
+    return 0;
+}
+
+int journal_open(CommandJournal *j, const char *path)
+{
+    memset(j, 0, sizeof(*j));
+    if (mapped_file_create(&j->file, path, JOURNAL_INITIAL_SIZE) != 0)
+    {
+        PATIKA_LOG_ERROR("journal: could not create %s", path);
+        memset(j, 0, sizeof(*j));
+        return -1;
+    }
+
+    memset(j->file.base, 0, JOURNAL_HEADER_SIZE);
+    patika_stream_write_header(j->file.base, JOURNAL_HEADER_SIZE);
+    wr_u32(j->file.base + 8, JOURNAL_MAGIC);
+    j->used = JOURNAL_HEADER_SIZE;
+    return 0;
+}
+
+void journal_close(CommandJournal *j)
+{
+    if (!journal_active(j))
+        return;
+    if (j->block_start)
+        journal_end_tick(j);
+
+    size_t index_bytes = (size_t)j->index_count * sizeof(uint64_t);
+    if (journal_reserve(j, index_bytes) != 0)
+        return;
+
+    uint64_t index_offset = j->used;
+    for (uint64_t i = 0; i < j->index_count; i++)
+        wr_u64(j->file.base + j->used + i * 8, j->index[i]);
+    j->used += index_bytes;
+    wr_u64(j->file.base + 16, j->index_count);
+    wr_u64(j->file.base + 24, index_offset);
+    journal_release(j);
+}
+
+void journal_begin_tick(CommandJournal *j, uint64_t tick)
+{
+    if (!journal_active(j))
+        return;
+
+    if (j->index_count == j->index_capacity)
+    {
+        uint64_t capacity = j->index_capacity ? j->index_capacity * 2 : 1024;
+        uint64_t *index = realloc(j->index, (size_t)capacity * sizeof(uint64_t));
+        if (!index)
+        {
+            PATIKA_LOG_ERROR("journal: tick index allocation failed, recording stopped");
+            journal_release(j);
+            return;
+        }
+        j->index = index;
+        j->index_capacity = capacity;
+    }
+
+    if (journal_reserve(j, JOURNAL_BLOCK_HEADER_SIZE) != 0)
+        return;
+    j->index[j->index_count++] = j->used;
+    j->block_start = j->used;
+    j->block_count = 0;
+    wr_u64(j->file.base + j->used, tick);
+    j->used += JOURNAL_BLOCK_HEADER_SIZE;
+}
+
+void journal_record(CommandJournal *j, const PatikaCommand *cmd)
+{
+    if (!journal_active(j) || !j->block_start)
+        return;
+
+    size_t size = stream_encoded_size(cmd);
+    if (size == 0)
+    {
+        PATIKA_LOG_DEBUG("journal: command type %d has no encoding, skipped", (int)cmd->type);
+        return;
+    }
+    if (journal_reserve(j, size) != 0)
+        return;
+
+    j->used += patika_stream_encode(cmd, j->file.base + j->used, size);
+    j->block_count++;
+}
+
+void journal_end_tick(CommandJournal *j)
+{
+    if (!journal_active(j) || !j->block_start)
+        return;
+
+    uint8_t *block = j->file.base + j->block_start;
+    wr_u32(block + 8, j->block_count);
+    wr_u32(block + 12, (uint32_t)(j->used - j->block_start - JOURNAL_BLOCK_HEADER_SIZE));
+    j->block_start = 0;
+}
+
+/* returns the block at offset if it is well formed, NULL otherwise */
+static const uint8_t *replay_block(const MappedFile *f, uint64_t offset, uint64_t expected_tick,
+                                   uint32_t *out_count, size_t *out_len)
+{
+    if (offset < JOURNAL_HEADER_SIZE || offset > f->size ||
+        f->size - offset < JOURNAL_BLOCK_HEADER_SIZE)
+        return NULL;
+
+    const uint8_t *block = f->base + offset;
+    uint32_t count = rd_u32(block + 8);
+    size_t len = rd_u32(block + 12);
+    if (rd_u64(block) != expected_tick ||
+        len > f->size - offset - JOURNAL_BLOCK_HEADER_SIZE)
+        return NULL;
+
+    uint32_t validated;
+    if (stream_validate_records(block + JOURNAL_BLOCK_HEADER_SIZE, len, &validated) != PATIKA_OK ||
+        validated != count)
+        return NULL;
+
+    *out_count = count;
+    *out_len = len;
+    return block + JOURNAL_BLOCK_HEADER_SIZE;
+}
+
+PATIKA_API PatikaError patika_replay(PatikaHandle handle, const char *path, uint64_t *out_ticks)
+{
+    if (out_ticks)
+        *out_ticks = 0;
+    if (!handle || !path)
+        return PATIKA_ERR_NULL_HANDLE;
+
+    MappedFile f = {0};
+    if (mapped_file_open_read(&f, path) != 0)
+    {
+        PATIKA_LOG_ERROR("replay: could not open %s", path);
+        return PATIKA_ERR_IO;
+    }
+
+    PatikaError result = PATIKA_OK;
+    if (f.size < JOURNAL_HEADER_SIZE || stream_check_header(f.base, f.size) != PATIKA_OK ||
+        rd_u32(f.base + 8) != JOURNAL_MAGIC)
+    {
+        mapped_file_close(&f, 0);
+        return PATIKA_ERR_BAD_STREAM;
+    }
+
+    uint64_t tick_count = rd_u64(f.base + 16);
+    uint64_t index_offset = rd_u64(f.base + 24);
+    int indexed = index_offset != 0 && index_offset <= f.size &&
+                  (f.size - index_offset) / 8 >= tick_count;
+    if (!indexed)
+        PATIKA_LOG_WARN("replay: %s has no tick index, scanning blocks", path);
+
+    uint64_t offset = JOURNAL_HEADER_SIZE;
+    uint64_t first_tick = f.size >= JOURNAL_HEADER_SIZE + JOURNAL_BLOCK_HEADER_SIZE
+                              ? rd_u64(f.base + JOURNAL_HEADER_SIZE)
+                              : 0;
+    uint64_t replayed = 0;
+
+    for (;;)
+    {
+        if (indexed)
+        {
+            if (replayed == tick_count)
+                break;
+            offset = rd_u64(f.base + index_offset + replayed * 8);
+        }
+        else if (offset + JOURNAL_BLOCK_HEADER_SIZE > f.size)
+        {
+            break;
+        }
+
+        uint32_t count;
+        size_t len;
+        const uint8_t *p = replay_block(&f, offset, first_tick + replayed, &count, &len);
+        if (!p)
+        {
+            // an unindexed journal may end in a block the writer never finished
+            if (indexed)
+                result = PATIKA_ERR_BAD_STREAM;
+            break;
+        }
+
+        /* a block is the order commands executed in, after coalescing,
+         * sorting and scheduled firing: run it as is, never re-sort it */
+        journal_begin_tick(&handle->journal, handle->stats.total_ticks);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            PatikaCommand cmd;
+            p = stream_decode_record(&handle->payloads, p, &cmd);
+            process_command(handle, &cmd);
+        }
+        journal_end_tick(&handle->journal);
+        tick_finish(handle);
+
+        offset += JOURNAL_BLOCK_HEADER_SIZE + len;
+        replayed++;
+    }
+
+    mapped_file_close(&f, 0);
+    if (out_ticks)
+        *out_ticks = replayed;
+    return result;
+}
@@ -0,0 +1,187 @@
+#include "internal/patika_internal.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/*
+ * Per-producer command lanes.
+ *
+ * Each registered producer owns one SPSC ring, so producers never contend on
+ * a shared head. A full lane only rejects its own producer. The simulation
+ * thread drains lanes after the shared queue, in lane id order and FIFO
+ * within a lane, which keeps the merge deterministic for a given set of
+ * submissions.
+ */
+
+static uint32_t lane_round_up_pow2(uint32_t v) {
+  uint32_t p = 2;
+  while (p < v && p < 0x80000000u)
+    p <<= 1;
+  return p;
+}
+
+void lanes_init(CommandLanes *l, uint32_t max_lanes, uint32_t lane_size) {
+  l->lanes = NULL;
+  l->max_lanes = 0;
+  atomic_init(&l->registered, 0);
+  if (max_lanes == 0) {
+    return;
+  }
+
+  l->lanes = (CommandLane *)calloc(max_lanes, sizeof(CommandLane));
+  if (!l->lanes) {
+    return;
+  }
+
+  uint32_t capacity = lane_round_up_pow2(lane_size);
+  for (uint32_t i = 0; i < max_lanes; i++) {
+    CommandLane *lane = &l->lanes[i];
+    lane->buffer = (PatikaCommand *)calloc(capacity, sizeof(PatikaCommand));
+    if (!lane->buffer) {
+      l->max_lanes = i; // keep the lanes that did allocate
+      return;
+    }
+    lane->capacity = capacity;
+    lane->mask = capacity - 1;
+    atomic_init(&lane->head, 0);
+    atomic_init(&lane->tail, 0);
+    atomic_init(&lane->submitted, 0);
+    atomic_init(&lane->queue_full, 0);
+  }
+  l->max_lanes = max_lanes;
+}
+
+void lanes_destroy(CommandLanes *l) {
+  if (l->lanes) {
+    for (uint32_t i = 0; i < l->max_lanes; i++) {
+      free(l->lanes[i].buffer);
+    }
+  }
+  free(l->lanes);
+  l->lanes = NULL;
+  l->max_lanes = 0;
+}
+
+/**
+ * @brief Hands out the next free lane id (thread-safe).
+ * @return Lane id, or UINT32_MAX when every lane is taken.
+ */
+uint32_t lanes_register(CommandLanes *l) {
+  uint32_t id = atomic_load_explicit(&l->registered, memory_order_relaxed);
+  do {
+    if (id >= l->max_lanes) {
+      return UINT32_MAX;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &l->registered, &id, id + 1, memory_order_acq_rel, memory_order_relaxed));
+  return id;
+}
+
+/**
+ * @brief Pushes commands to a lane (owning producer only).
+ * @return Number of commands accepted, a prefix of cmds.
+ */
+uint32_t lane_push_batch(CommandLane *lane, const PatikaCommand *cmds,
+                         uint32_t count, PatikaSubmitMode mode) {
+  uint32_t head = atomic_load_explicit(&lane->head, memory_order_relaxed);
+  uint32_t free_slots = lane->capacity - (head - lane->cached_tail);
+  if (free_slots < count) {
+    lane->cached_tail = atomic_load_explicit(&lane->tail, memory_order_acquire);
+    free_slots = lane->capacity - (head - lane->cached_tail);
+  }
+
+  uint32_t n = count;
+  if (free_slots < count) {
+    atomic_fetch_add_explicit(&lane->queue_full, 1, memory_order_relaxed);
+    if (mode == PATIKA_SUBMIT_ALL_OR_NOTHING) {
+      return 0;
+    }
+    n = free_slots;
+  }
+
+  for (uint32_t i = 0; i < n; i++) {
+    lane->buffer[(head + i) & lane->mask] = cmds[i];
+  }
+  atomic_store_explicit(&lane->head, head + n, memory_order_release);
+  atomic_fetch_add_explicit(&lane->submitted, n, memory_order_relaxed);
+  return n;
+}
+
+/**
+ * @brief Pops a command from a lane (simulation thread only).
+ * @return PATIKA_OK on success, PATIKA_ERR_CAPACITY if the lane is empty.
+ */
+PatikaError lane_pop(CommandLane *lane, PatikaCommand *out) {
+  uint32_t tail = atomic_load_explicit(&lane->tail, memory_order_relaxed);
+  if (tail == lane->cached_head) {
+    lane->cached_head = atomic_load_explicit(&lane->head, memory_order_acquire);
+    if (tail == lane->cached_head) {
+      return PATIKA_ERR_CAPACITY; // EMPTY
+    }
+  }
+
+  *out = lane->buffer[tail & lane->mask];
+  atomic_store_explicit(&lane->tail, tail + 1, memory_order_release);
+  return PATIKA_OK;
+}
+
+PATIKA_API PatikaProducerToken patika_register_producer(PatikaHandle handle) {
+  if (!handle) {
+    return PATIKA_INVALID_PRODUCER_TOKEN;
+  }
+  uint32_t id = lanes_register(&handle->lanes);
+  return id == UINT32_MAX ? PATIKA_INVALID_PRODUCER_TOKEN : id;
+}
+
+static CommandLane *lane_for_token(PatikaHandle handle,
+                                   PatikaProducerToken token) {
+  if (!handle || token >= atomic_load_explicit(&handle->lanes.registered,
+                                               memory_order_relaxed)) {
+    return NULL;
+  }
+  return &handle->lanes.lanes[token];
+}
+
+PATIKA_API PatikaError patika_lane_submit(PatikaHandle handle,
+                                          PatikaProducerToken token,
+                                          const PatikaCommand *cmd) {
+  if (!handle) {
+    return PATIKA_ERR_NULL_HANDLE;
+  }
+  CommandLane *lane = lane_for_token(handle, token);
+  if (!lane) {
+    return PATIKA_ERR_INVALID_ID;
+  }
+  return lane_push_batch(lane, cmd, 1, PATIKA_SUBMIT_ALL_OR_NOTHING) == 1
+             ? PATIKA_OK
+             : PATIKA_ERR_QUEUE_FULL;
+}
+
+PATIKA_API uint32_t patika_lane_submit_batch(PatikaHandle handle,
+                                             PatikaProducerToken token,
+                                             const PatikaCommand *cmds,
+                                             uint32_t count,
+                                             PatikaSubmitMode mode) {
+  CommandLane *lane = lane_for_token(handle, token);
+  if (!lane || !cmds || count == 0) {
+    return 0;
+  }
+  return lane_push_batch(lane, cmds, count, mode);
+}
+
+PATIKA_API PatikaError patika_get_lane_stats(PatikaHandle handle,
+                                             PatikaProducerToken token,
+                                             PatikaLaneStats *out) {
+  if (!handle || !out) {
+    return PATIKA_ERR_NULL_HANDLE;
+  }
+  CommandLane *lane = lane_for_token(handle, token);
+  if (!lane) {
+    return PATIKA_ERR_INVALID_ID;
+  }
+  out->submitted = atomic_load_explicit(&lane->submitted, memory_order_relaxed);
+  out->queue_full =
+      atomic_load_explicit(&lane->queue_full, memory_order_relaxed);
+  out->pending = atomic_load_explicit(&lane->head, memory_order_relaxed) -
+                 atomic_load_explicit(&lane->tail, memory_order_relaxed);
+  return PATIKA_OK;
+}
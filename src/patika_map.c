@@ -5,6 +5,10 @@
 // safe absolute for int32_t
 #define ABS_I32(x) ((x) < 0 ? -(x) : (x))
 
+static inline int32_t map_get_radius(MapGrid *map) {
+    return (map->width - 1) / 2;
+}
+
 void map_init(MapGrid *map, uint8_t type, uint32_t width, uint32_t height)
 {
     map->type = type;
@@ -31,7 +35,7 @@ void map_init(MapGrid *map, uint8_t type, uint32_t width, uint32_t height)
             map->tiles[i].occupancy = 0;
             map->tiles[i].sectorID = 0;
         }
-        map->agent_grid = calloc(tile_count, sizeof(AgentID)); // TODO: for beta there is only one agent per tile, it will be changed
+        map->agent_grid = calloc(tile_count, sizeof(uint32_t)); // TODO: for beta there is only one agent per tile, it will be changed
         if (!map->agent_grid)
         {
             PATIKA_LOG_ERROR("map_init: failed to allocate memory for hexagonal map agent grid");
@@ -41,7 +45,7 @@ void map_init(MapGrid *map, uint8_t type, uint32_t width, uint32_t height)
         }
         for (int i = 0; i < tile_count; i++)
         {
-            map->agent_grid[i] = PATIKA_INVALID_AGENT_ID; //means empty
+            map->agent_grid[i] = PATIKA_INVALID_AGENT_INDEX; //means empty
         }
         // Store dimensions as diameter for indexing
         map->width = (radius * 2) + 1;
@@ -56,7 +60,7 @@ void map_init(MapGrid *map, uint8_t type, uint32_t width, uint32_t height)
             PATIKA_LOG_ERROR("map_init: failed to allocate memory for rectangular map tiles");
             return;
         }
-        map->agent_grid = calloc((unsigned long)width * height, sizeof(AgentID)); // maybe
+        map->agent_grid = calloc((unsigned long)width * height, sizeof(uint32_t));
         if (!map->agent_grid)
         {
             PATIKA_LOG_ERROR("map_init: failed to allocate memory for rectangular map agent grid");
@@ -72,7 +76,7 @@ void map_init(MapGrid *map, uint8_t type, uint32_t width, uint32_t height)
         }
         for (int i = 0; i < tile_count; i++)
         {
-            map->agent_grid[i] = PATIKA_INVALID_AGENT_ID;
+            map->agent_grid[i] = PATIKA_INVALID_AGENT_INDEX;
         }
     }
     else 
@@ -150,9 +154,9 @@ void map_set_tile_state(MapGrid *map, int32_t q, int32_t r, uint8_t state)
 uint32_t map_get_agent_grid(MapGrid *map, int32_t q, int32_t r)
 {
     if (!map->agent_grid)
-        return PATIKA_INVALID_AGENT_ID;
+        return PATIKA_INVALID_AGENT_INDEX;
     if (!map_in_bounds(map, q, r))
-        return PATIKA_INVALID_AGENT_ID;
+        return PATIKA_INVALID_AGENT_INDEX;
 
     if (map->type == MAP_TYPE_RECTANGULAR)
     {
@@ -168,7 +172,7 @@ uint32_t map_get_agent_grid(MapGrid *map, int32_t q, int32_t r)
     else 
     {
         PATIKA_LOG_ERROR("Unknown map type %d in map_get_agent_grid", map->type);
-        return PATIKA_INVALID_AGENT_ID;
+        return PATIKA_INVALID_AGENT_INDEX;
     }
 }
 
@@ -192,8 +196,3 @@ void map_set_agent_grid(MapGrid *map, int32_t q, int32_t r, uint32_t value)
         map->agent_grid[offset_r * map->width + offset_q] = value;
     }
 }
-
-static inline int32_t map_get_radius(MapGrid *map) {
-    return (map->width - 1) / 2;
-}
-
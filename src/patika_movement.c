@@ -2,20 +2,20 @@
 
 
 void agent_arrive_at_tile(struct PatikaContext *ctx, AgentSlot *agent) {
-    map_set_agent_grid(&ctx->map, agent->pos_q, agent->pos_r, PATIKA_INVALID_AGENT_ID);
+    map_set_agent_grid(&ctx->map, agent->pos_q, agent->pos_r, PATIKA_INVALID_AGENT_INDEX);
 
     uint32_t grid_val = map_get_agent_grid(&ctx->map, agent->next_q, agent->next_r);
-    AgentID occupant_id = grid_val & AGENT_GRID_AGENT_MASK;
+    AgentIndex occupant_id = map_extract_agent_id(grid_val);
 
-    if (occupant_id != PATIKA_INVALID_AGENT_ID && occupant_id != agent->id) {
-        AgentSlot *occupant = agent_pool_get(&ctx->agents, occupant_id);
+    if (occupant_id != PATIKA_INVALID_AGENT_INDEX && occupant_id != agent_index(agent->id)) {
+        AgentSlot *occupant = agent_pool_slot(&ctx->agents, occupant_id);
 
         if (occupant && occupant->active) {
             // check collision
             if (agent->collision_data.collision_mask & occupant->collision_data.layer) {
-                PATIKA_INTERNAL_LOG_ERROR("collision detected not suppose to happen, agent %d turns back previous location", agent->id);
-                map_set_agent_grid(&ctx->map, agent->pos_q, agent->pos_r, agent->id);
-                agent->state = STATE_CALCULATING;
+                PATIKA_INTERNAL_LOG_ERROR("collision detected not suppose to happen, agent %" PATIKA_PRI_AGENT_ID " turns back previous location", agent->id);
+                map_set_agent_grid(&ctx->map, agent->pos_q, agent->pos_r, agent_index(agent->id));
+                agent_set_state(&ctx->agents, agent, STATE_CALCULATING);
                 agent->progress = 0;
                 return;
             }
@@ -23,21 +23,27 @@ void agent_arrive_at_tile(struct PatikaContext *ctx, AgentSlot *agent) {
             if (agent->collision_data.aggression_mask & occupant->collision_data.layer) {
                 agent->interaction_data.type = INTERACT_ATTACK;
                 agent->interaction_data.data.agent.target_id = occupant_id;
+
+                PatikaInteractionRecord rec = {agent->id, occupant->id, agent->next_q, agent->next_r,
+                                               INTERACT_ATTACK};
+                emit_record_interaction(ctx, &rec);
             }
         }
     }
 
-    map_set_agent_grid(&ctx->map, agent->next_q, agent->next_r, agent->id);
+    map_set_agent_grid(&ctx->map, agent->next_q, agent->next_r, agent_index(agent->id));
     agent->pos_q = agent->next_q;
     agent->pos_r = agent->next_r;
     agent->progress = 0;
+    movement_deltas_record(&ctx->deltas, agent);
+    agent_mark_dirty(&ctx->agents, agent);
 
     if (agent->pos_q == agent->target_q && agent->pos_r == agent->target_r) {
-        agent->state = STATE_IDLE;
+        agent_set_state(&ctx->agents, agent, STATE_IDLE);
         PatikaEvent evt = {EVENT_REACHED_GOAL, agent->id, agent->pos_q, agent->pos_r};
-        spsc_push(&ctx->event_queue, &evt);
+        emit_event(ctx, &evt, agent);
     } else {
-        agent->state = STATE_CALCULATING;
+        agent_set_state(&ctx->agents, agent, STATE_CALCULATING);
     }
 }
 
@@ -49,21 +55,23 @@ void process_movement(struct PatikaContext *ctx, AgentSlot *agent)
 
     if (!tile || tile->state != 0)
     {
-        agent->state = STATE_CALCULATING;
+        agent_set_state(&ctx->agents, agent, STATE_CALCULATING);
         return;
     }
 
     agent->pos_q = agent->next_q;
     agent->pos_r = agent->next_r;
+    movement_deltas_record(&ctx->deltas, agent);
+    agent_mark_dirty(&ctx->agents, agent);
 
     if (agent->pos_q == agent->target_q && agent->pos_r == agent->target_r)
     {
-        agent->state = STATE_IDLE;
+        agent_set_state(&ctx->agents, agent, STATE_IDLE);
         PatikaEvent evt = {EVENT_REACHED_GOAL, agent->id, agent->pos_q, agent->pos_r};
-        spsc_push(&ctx->event_queue, &evt);
+        emit_event(ctx, &evt, agent);
     }
     else
     {
-        agent->state = STATE_CALCULATING;
+        agent_set_state(&ctx->agents, agent, STATE_CALCULATING);
     }
 }
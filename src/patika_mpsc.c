@@ -2,61 +2,177 @@
 #include <stdatomic.h>
 #include <stdlib.h>
 
+/*
+ * Bounded MPSC queue with per-slot sequence numbers (Vyukov).
+ *
+ * Slot i is free for enqueue position p when its sequence equals p, and holds
+ * a published command for dequeue position p when its sequence equals p + 1.
+ * Producers claim a position with one CAS on head, copy the command and only
+ * then publish the slot, so the consumer never observes a half-written
+ * command. The consumer hands the slot back by advancing its sequence by one
+ * lap (p + capacity). Producers never read tail.
+ */
+
+static uint32_t round_up_pow2(uint32_t v)
+{
+    uint32_t p = 2;
+    while (p < v && p < 0x80000000u)
+        p <<= 1;
+    return p;
+}
+
 void mpsc_init(MPSCCommandQueue *q, uint32_t capacity) {
-  q->buffer = (PatikaCommand *)calloc(capacity, sizeof(PatikaCommand));
-  if (!q->buffer) {
+  capacity = round_up_pow2(capacity);
+  q->slots = (MPSCSlot *)calloc(capacity, sizeof(MPSCSlot));
+  if (!q->slots) {
     q->capacity = 0;
+    q->mask = 0;
     return;
   }
   q->capacity = capacity;
+  q->mask = capacity - 1;
+  for (uint32_t i = 0; i < capacity; i++) {
+    atomic_init(&q->slots[i].sequence, i);
+  }
   atomic_init(&q->head, 0);
   q->tail = 0;
 }
 
 void mpsc_destroy(MPSCCommandQueue *q) {
-  free(q->buffer);
-  q->buffer = NULL;
+  free(q->slots);
+  q->slots = NULL;
 }
 
 /**
  * @brief Pushes a command to the queue (thread-safe).
- * @return 0 on success, -1 if queue is full.
+ * @return PATIKA_OK on success, PATIKA_ERR_QUEUE_FULL if queue is full.
  */
 PatikaError mpsc_push(MPSCCommandQueue *q, const PatikaCommand *cmd) {
-  uint32_t current_head;
-  uint32_t next_head;
+  if (!q->slots) {
+    return PATIKA_ERR_QUEUE_FULL;
+  }
+
+  uint32_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+  for (;;) {
+    MPSCSlot *slot = &q->slots[pos & q->mask];
+    uint32_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        slot->cmd = *cmd;
+        atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+        return PATIKA_OK;
+      }
+      // lost the race, pos was reloaded by the failed CAS
+    } else if (diff < 0) {
+      return PATIKA_ERR_QUEUE_FULL; // consumer has not freed this slot yet
+    } else {
+      pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    }
+  }
+}
+
+static inline int mpsc_slot_free(MPSCCommandQueue *q, uint32_t pos) {
+  return atomic_load_explicit(&q->slots[pos & q->mask].sequence,
+                              memory_order_acquire) == pos;
+}
+
+/**
+ * @brief Reserves up to n consecutive slots with a single CAS (thread-safe).
+ * @details The consumer frees slots in order, so if the last slot of a range
+ *          is free the whole range is; partial reservations binary search the
+ *          longest free prefix instead of probing slot by slot.
+ * @param min_count Smallest acceptable reservation (n for all-or-nothing).
+ * @return Number of slots reserved, 0 if fewer than min_count were free.
+ */
+uint32_t mpsc_reserve(MPSCCommandQueue *q, uint32_t n, uint32_t min_count,
+                      uint32_t *out_pos) {
+  if (!q->slots || n == 0) {
+    return 0;
+  }
+  if (n > q->capacity) {
+    n = q->capacity;
+  }
+  if (min_count > n) {
+    return 0;
+  }
 
-  do {
-    current_head = atomic_load_explicit(&q->head, memory_order_relaxed);
-    next_head = (current_head + 1) % q->capacity;
+  uint32_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+  for (;;) {
+    uint32_t seq = atomic_load_explicit(&q->slots[pos & q->mask].sequence,
+                                        memory_order_acquire);
+    int32_t diff = (int32_t)(seq - pos);
+    if (diff > 0) {
+      pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+      continue; // head moved under us
+    }
+    if (diff < 0) {
+      return 0; // FULL
+    }
 
-    // Check if full
-    if (next_head == q->tail) {
-      return -1; // QUEUE_FULL
+    uint32_t count = n;
+    if (!mpsc_slot_free(q, pos + n - 1)) {
+      uint32_t lo = 1, hi = n - 1; // slot pos is free, pos + n - 1 is not
+      while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if (mpsc_slot_free(q, pos + mid - 1)) {
+          lo = mid;
+        } else {
+          hi = mid - 1;
+        }
+      }
+      count = lo;
+    }
+    if (count < min_count) {
+      return 0;
     }
-  } while (!atomic_compare_exchange_weak_explicit(
-      &q->head, &current_head, next_head, memory_order_release,
-      memory_order_relaxed));
 
-  // Write command to reserved slot
-  q->buffer[current_head] = *cmd;
+    if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + count,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed)) {
+      *out_pos = pos;
+      return count;
+    }
+  }
+}
 
-  return PATIKA_OK;
+/**
+ * @brief Publishes a reserved range (thread-safe).
+ * @details Slots are released back to front: the consumer stops at the first
+ *          slot of the range until its store lands, by which point the rest
+ *          of the range is already visible, so the batch appears as a unit.
+ */
+void mpsc_publish(MPSCCommandQueue *q, uint32_t pos, uint32_t count) {
+  for (uint32_t i = count; i-- > 0;) {
+    atomic_store_explicit(&q->slots[(pos + i) & q->mask].sequence, pos + i + 1,
+                          memory_order_release);
+  }
 }
 
 /**
  * @brief Pops a command from the queue (single consumer only).
- * @return 0 on success, -1 if queue is empty.
+ * @return 0 on success, -1 if queue is empty (or the next slot is still being
+ *         written).
  */
 PatikaError mpsc_pop(MPSCCommandQueue *q, PatikaCommand *out) {
-  uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+  if (!q->slots) {
+    return -1;
+  }
+
+  MPSCSlot *slot = &q->slots[q->tail & q->mask];
+  uint32_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
 
-  if (q->tail == head) {
+  if ((int32_t)(seq - (q->tail + 1)) < 0) {
     return -1; // EMPTY
   }
 
-  *out = q->buffer[q->tail];
-  q->tail = (q->tail + 1) % q->capacity;
+  *out = slot->cmd;
+  atomic_store_explicit(&slot->sequence, q->tail + q->capacity,
+                        memory_order_release);
+  q->tail++;
 
   return 0; // SUCCESS
 }
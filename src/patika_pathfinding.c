@@ -13,9 +13,9 @@ void compute_next_step(struct PatikaContext *ctx, AgentSlot *agent)
 {
     if (agent->pos_q == agent->target_q && agent->pos_r == agent->target_r && agent->behavior == BEHAVIOR_IDLE)
     {
-        agent->state = STATE_IDLE;
+        agent_set_state(&ctx->agents, agent, STATE_IDLE);
         PatikaEvent event = {EVENT_REACHED_GOAL, agent->id, agent->pos_q, agent->pos_r};
-        spsc_push(&ctx->event_queue, &event);
+        emit_event(ctx, &event, agent);
         return;
     }
 
@@ -54,14 +54,15 @@ void compute_next_step(struct PatikaContext *ctx, AgentSlot *agent)
         int choice = candidates[pcg32_next(&ctx->rng) % candidate_count];
         agent->next_q = agent->pos_q + HEX_DIRS[choice][0];
         agent->next_r = agent->pos_r + HEX_DIRS[choice][1];
-        agent->state = STATE_MOVING;
+        agent_mark_dirty(&ctx->agents, agent);
+        agent_set_state(&ctx->agents, agent, STATE_MOVING);
         PATIKA_LOG_DEBUG("Agent moving...");
     }
     else
     {
-        agent->state = STATE_IDLE;
+        agent_set_state(&ctx->agents, agent, STATE_IDLE);
         PatikaEvent evt = {EVENT_STUCK, agent->id, agent->pos_q, agent->pos_r};
-        spsc_push(&ctx->event_queue, &evt);
+        emit_event(ctx, &evt, agent);
         PATIKA_LOG_DEBUG("Agent IDLE, canditate count <= 0");
     }
 
@@ -73,7 +74,7 @@ void compute_patrol(struct PatikaContext *ctx, AgentSlot *agent)
 
     if (!barrack)
     {
-        agent->state = STATE_REMOVE_QUEUE;
+        agent_set_state(&ctx->agents, agent, STATE_REMOVE_QUEUE);
         return;
     }
 
@@ -109,13 +110,14 @@ void compute_patrol(struct PatikaContext *ctx, AgentSlot *agent)
         int choice = candidates[pcg32_next(&ctx->rng) % count];
         agent->next_q = agent->pos_q + HEX_DIRS[choice][0];
         agent->next_r = agent->pos_r + HEX_DIRS[choice][1];
+        agent_mark_dirty(&ctx->agents, agent);
 
         // mark as moving so tick applies the move
-        agent->state = STATE_MOVING;
+        agent_set_state(&ctx->agents, agent, STATE_MOVING);
     }
     else
     {
         // stuck or at edge of patrol radius
-        agent->state = STATE_IDLE;
+        agent_set_state(&ctx->agents, agent, STATE_IDLE);
     }
 }
@@ -0,0 +1,235 @@
+#include "internal/patika_internal.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/*
+ * Payload slabs
+ *
+ * Every producer thread gets its own slab per context. Blocks are carved from
+ * chunks owned by that slab and handed out from a thread-private free list.
+ * Released blocks never go back to the global allocator: they are pushed
+ * onto the owning slab's lock-free return list, which the owner takes over
+ * in one exchange when its private list runs dry. The sim thread pushes
+ * consumed payloads, and producers push too, through patika_free_payload and
+ * when patika_schedule_command fails. Any number of pushers is fine: the only
+ * pop is the owner's exchange of the whole list, which never reads a node's
+ * next pointer, so the stack has no ABA window.
+ */
+
+#define PAYLOAD_CLASS_COUNT 4
+#define PAYLOAD_CHUNK_BLOCKS 64
+
+static const uint32_t PAYLOAD_CLASS_SIZE[PAYLOAD_CLASS_COUNT] = {64, 128, 256, 512};
+
+typedef struct PayloadBlock PayloadBlock;
+typedef struct PayloadChunk PayloadChunk;
+
+/* header in front of every payload, keeps the payload 16-byte aligned */
+struct PayloadBlock
+{
+    _Alignas(16) PayloadSlab *owner; // NULL: oversize block straight from malloc
+    PayloadBlock *next;
+    uint32_t size_class;
+};
+
+struct PayloadChunk
+{
+    _Alignas(16) PayloadChunk *next;
+};
+
+struct PayloadSlab
+{
+    const void *owner_thread;
+    PayloadBlock *free_list[PAYLOAD_CLASS_COUNT];          // owner thread only
+    _Atomic(PayloadBlock *) returned[PAYLOAD_CLASS_COUNT]; // pushed by sim thread
+    PayloadChunk *chunks;
+    PayloadSlab *next;
+};
+
+static _Atomic uint64_t payload_pool_serial = 1;
+
+/* address identifies the calling thread, cache skips the registry walk */
+static PATIKA_THREAD_LOCAL char tls_thread_tag;
+static PATIKA_THREAD_LOCAL struct
+{
+    const PayloadPool *pool;
+    uint64_t serial;
+    PayloadSlab *slab;
+} tls_slab_cache;
+
+void payload_pool_init(PayloadPool *pool)
+{
+    atomic_init(&pool->slabs, NULL);
+    pool->serial = atomic_fetch_add(&payload_pool_serial, 1);
+}
+
+void payload_pool_destroy(PayloadPool *pool)
+{
+    PayloadSlab *slab = atomic_load(&pool->slabs);
+    while (slab)
+    {
+        PayloadSlab *next_slab = slab->next;
+        PayloadChunk *chunk = slab->chunks;
+        while (chunk)
+        {
+            PayloadChunk *next_chunk = chunk->next;
+            free(chunk);
+            chunk = next_chunk;
+        }
+        free(slab);
+        slab = next_slab;
+    }
+    atomic_store(&pool->slabs, NULL);
+}
+
+static PayloadSlab *payload_slab_for_thread(PayloadPool *pool)
+{
+    if (tls_slab_cache.pool == pool && tls_slab_cache.serial == pool->serial)
+        return tls_slab_cache.slab;
+
+    PayloadSlab *slab = atomic_load_explicit(&pool->slabs, memory_order_acquire);
+    while (slab && slab->owner_thread != &tls_thread_tag)
+        slab = slab->next;
+
+    if (!slab)
+    {
+        slab = calloc(1, sizeof(PayloadSlab));
+        if (!slab)
+            return NULL;
+        slab->owner_thread = &tls_thread_tag;
+        for (int c = 0; c < PAYLOAD_CLASS_COUNT; c++)
+            atomic_init(&slab->returned[c], NULL);
+
+        PayloadSlab *head = atomic_load_explicit(&pool->slabs, memory_order_relaxed);
+        do
+        {
+            slab->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&pool->slabs, &head, slab,
+                                                        memory_order_release,
+                                                        memory_order_relaxed));
+    }
+
+    tls_slab_cache.pool = pool;
+    tls_slab_cache.serial = pool->serial;
+    tls_slab_cache.slab = slab;
+    return slab;
+}
+
+static int payload_slab_refill(PayloadSlab *slab, uint32_t size_class)
+{
+    uint32_t block_size = PAYLOAD_CLASS_SIZE[size_class];
+    PayloadChunk *chunk = malloc(sizeof(PayloadChunk) + (size_t)block_size * PAYLOAD_CHUNK_BLOCKS);
+    if (!chunk)
+        return -1;
+
+    chunk->next = slab->chunks;
+    slab->chunks = chunk;
+
+    unsigned char *base = (unsigned char *)(chunk + 1);
+    for (uint32_t i = 0; i < PAYLOAD_CHUNK_BLOCKS; i++)
+    {
+        PayloadBlock *block = (PayloadBlock *)(base + (size_t)i * block_size);
+        block->owner = slab;
+        block->size_class = size_class;
+        block->next = slab->free_list[size_class];
+        slab->free_list[size_class] = block;
+    }
+    return 0;
+}
+
+void *payload_pool_alloc(PayloadPool *pool, size_t size)
+{
+    uint32_t size_class = 0;
+    while (size_class < PAYLOAD_CLASS_COUNT &&
+           size + sizeof(PayloadBlock) > PAYLOAD_CLASS_SIZE[size_class])
+        size_class++;
+
+    PayloadSlab *slab = size_class < PAYLOAD_CLASS_COUNT ? payload_slab_for_thread(pool) : NULL;
+    if (!slab)
+    {
+        // oversize (or no slab): plain malloc, released with free()
+        PayloadBlock *block = malloc(sizeof(PayloadBlock) + size);
+        if (!block)
+            return NULL;
+        block->owner = NULL;
+        block->next = NULL;
+        block->size_class = PAYLOAD_CLASS_COUNT;
+        return block + 1;
+    }
+
+    PayloadBlock *block = slab->free_list[size_class];
+    if (!block)
+    {
+        block = atomic_exchange_explicit(&slab->returned[size_class], NULL, memory_order_acquire);
+        if (!block)
+        {
+            if (payload_slab_refill(slab, size_class) != 0)
+                return NULL;
+            block = slab->free_list[size_class];
+        }
+    }
+
+    slab->free_list[size_class] = block->next;
+    block->next = NULL;
+    return block + 1;
+}
+
+void payload_pool_release(void *payload)
+{
+    if (!payload)
+        return;
+
+    PayloadBlock *block = (PayloadBlock *)payload - 1;
+    PayloadSlab *slab = block->owner;
+    if (!slab)
+    {
+        free(block);
+        return;
+    }
+
+    _Atomic(PayloadBlock *) *head = &slab->returned[block->size_class];
+    PayloadBlock *top = atomic_load_explicit(head, memory_order_relaxed);
+    do
+    {
+        block->next = top;
+    } while (!atomic_compare_exchange_weak_explicit(head, &top, block,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+int command_has_payload(CommandType type)
+{
+    switch (type)
+    {
+    case CMD_ADD_AGENT:
+    case CMD_ADD_AGENT_WITH_BEHAVIOR:
+    case CMD_AGENT_ADD_GUARD_TILES:
+    case CMD_ADD_BARRACK:
+    case CMD_BARRACK_ADD_GUARD_TILES:
+    case CMD_SCHEDULE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+void command_release_payload(const PatikaCommand *cmd)
+{
+    if (cmd->flags & PATIKA_COMMAND_FLAG_POOLED_PAYLOAD)
+        payload_pool_release(cmd->large_command.payload);
+    else
+        free(cmd->large_command.payload);
+}
+
+PATIKA_API void *patika_alloc_payload(PatikaHandle handle, size_t size)
+{
+    if (!handle)
+        return NULL;
+    return payload_pool_alloc(&handle->payloads, size);
+}
+
+PATIKA_API void patika_free_payload(PatikaHandle handle, void *payload)
+{
+    (void)handle;
+    payload_pool_release(payload);
+}
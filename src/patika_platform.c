@@ -0,0 +1,252 @@
+#include "internal/patika_internal.h"
+
+/*
+ * Address-based waiting for producer backpressure: futex on Linux,
+ * WaitOnAddress on Windows, a short sleep-poll everywhere else. Callers
+ * always re-check their condition, so spurious and early wake-ups are fine.
+ *
+ * Memory-mapped files for the command journal: mmap on POSIX, file mappings
+ * on Windows.
+ *
+ * Event notification descriptors for epoll loops: eventfd, Linux only.
+ */
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t patika_now_ns(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0)
+        QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void patika_wait_on_address(_Atomic uint32_t *addr, uint32_t expected, uint64_t timeout_ns)
+{
+#if defined(__linux__)
+    struct timespec ts;
+    ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+    ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_PRIVATE, expected, &ts, NULL, 0);
+#elif defined(_WIN32)
+    DWORD ms = (DWORD)((timeout_ns + 999999ull) / 1000000ull);
+    WaitOnAddress((volatile VOID *)addr, &expected, sizeof(expected), ms);
+#else
+    uint64_t step = timeout_ns < 50000ull ? timeout_ns : 50000ull;
+    struct timespec ts = {0, (long)step};
+    if (atomic_load_explicit(addr, memory_order_acquire) == expected)
+        nanosleep(&ts, NULL);
+#endif
+}
+
+void patika_wake_address(_Atomic uint32_t *addr)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE_PRIVATE, INT32_MAX, NULL, NULL, 0);
+#elif defined(_WIN32)
+    WakeByAddressAll((PVOID)addr);
+#else
+    (void)addr;
+#endif
+}
+
+#if defined(_WIN32)
+
+static int mapped_file_map(MappedFile *f, size_t size)
+{
+    LARGE_INTEGER end;
+    end.QuadPart = (LONGLONG)size;
+    if (f->writable && (!SetFilePointerEx((HANDLE)f->file, end, NULL, FILE_BEGIN) ||
+                        !SetEndOfFile((HANDLE)f->file)))
+        return -1;
+
+    HANDLE mapping = CreateFileMappingA((HANDLE)f->file, NULL,
+                                        f->writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        (DWORD)(size >> 32), (DWORD)size, NULL);
+    if (!mapping)
+        return -1;
+    void *base = MapViewOfFile(mapping, f->writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    CloseHandle(mapping); // the view keeps the mapping alive
+    if (!base)
+        return -1;
+    f->base = (uint8_t *)base;
+    f->size = size;
+    return 0;
+}
+
+int mapped_file_create(MappedFile *f, const char *path, size_t size)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return -1;
+    f->file = (intptr_t)file;
+    f->writable = 1;
+    if (mapped_file_map(f, size) != 0)
+    {
+        CloseHandle(file);
+        return -1;
+    }
+    return 0;
+}
+
+int mapped_file_open_read(MappedFile *f, const char *path)
+{
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE)
+        return -1;
+    f->file = (intptr_t)file;
+    f->writable = 0;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+        mapped_file_map(f, (size_t)size.QuadPart) != 0)
+    {
+        CloseHandle(file);
+        return -1;
+    }
+    return 0;
+}
+
+int mapped_file_resize(MappedFile *f, size_t size)
+{
+    UnmapViewOfFile(f->base);
+    f->base = NULL;
+    return mapped_file_map(f, size);
+}
+
+void mapped_file_close(MappedFile *f, size_t final_size)
+{
+    if (f->base)
+        UnmapViewOfFile(f->base);
+    if (f->writable)
+    {
+        LARGE_INTEGER end;
+        end.QuadPart = (LONGLONG)final_size;
+        SetFilePointerEx((HANDLE)f->file, end, NULL, FILE_BEGIN);
+        SetEndOfFile((HANDLE)f->file);
+    }
+    CloseHandle((HANDLE)f->file);
+    f->base = NULL;
+    f->size = 0;
+}
+
+#else
+
+static int mapped_file_map(MappedFile *f, size_t size)
+{
+    if (f->writable && ftruncate((int)f->file, (off_t)size) != 0)
+        return -1;
+    void *base = mmap(NULL, size, f->writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      f->writable ? MAP_SHARED : MAP_PRIVATE, (int)f->file, 0);
+    if (base == MAP_FAILED)
+        return -1;
+    f->base = (uint8_t *)base;
+    f->size = size;
+    return 0;
+}
+
+int mapped_file_create(MappedFile *f, const char *path, size_t size)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    f->file = fd;
+    f->writable = 1;
+    if (mapped_file_map(f, size) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return 0;
+}
+
+int mapped_file_open_read(MappedFile *f, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    f->file = fd;
+    f->writable = 0;
+    if (fstat(fd, &st) != 0 || st.st_size == 0 || mapped_file_map(f, (size_t)st.st_size) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return 0;
+}
+
+int mapped_file_resize(MappedFile *f, size_t size)
+{
+    munmap(f->base, f->size);
+    f->base = NULL;
+    return mapped_file_map(f, size);
+}
+
+void mapped_file_close(MappedFile *f, size_t final_size)
+{
+    if (f->base)
+        munmap(f->base, f->size);
+    if (f->writable && ftruncate((int)f->file, (off_t)final_size) != 0)
+        PATIKA_LOG_WARN("mapped_file_close: could not trim file to %zu bytes", final_size);
+    close((int)f->file);
+    f->base = NULL;
+    f->size = 0;
+}
+
+#endif
+
+int patika_eventfd_create(void)
+{
+#if defined(__linux__)
+    return eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    return -1;
+#endif
+}
+
+void patika_eventfd_signal(int fd)
+{
+#if defined(__linux__)
+    uint64_t one = 1;
+    if (write(fd, &one, sizeof(one)) != (ssize_t)sizeof(one))
+        PATIKA_LOG_DEBUG("eventfd signal skipped, counter saturated");
+#else
+    (void)fd;
+#endif
+}
+
+void patika_eventfd_close(int fd)
+{
+#if defined(__linux__)
+    close(fd);
+#else
+    (void)fd;
+#endif
+}
@@ -29,6 +29,20 @@ BarrackSlot *barrack_pool_get(BarrackPool *pool, BuildingID id)
 void agent_pool_init(AgentPool *pool, uint32_t capacity)
 {
     pool->slots = calloc(capacity, sizeof(AgentSlot));
+    pool->active_list = calloc(capacity, sizeof(uint32_t));
+    pool->active_pos = calloc(capacity, sizeof(uint32_t));
+    pool->state_pos = calloc(capacity, sizeof(uint32_t));
+    for (int s = 0; s < PATIKA_AGENT_STATE_COUNT; s++)
+    {
+        pool->state_lists[s].indices = s == STATE_IDLE ? NULL : calloc(capacity, sizeof(uint32_t));
+        pool->state_lists[s].count = 0;
+    }
+    for (int b = 0; b < PATIKA_SNAPSHOT_BUFFERS; b++)
+    {
+        pool->snapshot_dirty[b].positions = calloc(capacity, sizeof(uint32_t));
+        pool->snapshot_dirty[b].marked = calloc(capacity, sizeof(uint8_t));
+        pool->snapshot_dirty[b].count = 0;
+    }
     pool->capacity = capacity;
     pool->active_count = 0;
     pool->free_head = 0;
@@ -36,7 +50,7 @@ void agent_pool_init(AgentPool *pool, uint32_t capacity)
     { // check for -2
         pool->slots[i].next_free_index = i + 1;
     }
-    pool->slots[capacity - 1].next_free_index = PATIKA_INVALID_AGENT_ID;
+    pool->slots[capacity - 1].next_free_index = PATIKA_INVALID_AGENT_INDEX;
 }
 
 BuildingID barrack_pool_allocate(BarrackPool *pool)
@@ -57,6 +71,18 @@ void agent_pool_destroy(AgentPool *pool)
     if (pool)
     {
         free(pool->slots);
+        free(pool->active_list);
+        free(pool->active_pos);
+        free(pool->state_pos);
+        for (int s = 0; s < PATIKA_AGENT_STATE_COUNT; s++)
+        {
+            free(pool->state_lists[s].indices);
+        }
+        for (int b = 0; b < PATIKA_SNAPSHOT_BUFFERS; b++)
+        {
+            free(pool->snapshot_dirty[b].positions);
+            free(pool->snapshot_dirty[b].marked);
+        }
     }
 }
 
@@ -66,14 +92,17 @@ AgentID agent_pool_allocate(AgentPool *pool)
     {
         return PATIKA_INVALID_AGENT_ID;
     }
-    if (pool->free_head == PATIKA_INVALID_AGENT_ID)
+    if (pool->free_head == PATIKA_INVALID_AGENT_INDEX)
     {
         return PATIKA_INVALID_AGENT_ID;
     }
-    uint16_t index = pool->free_head;
+    AgentIndex index = pool->free_head;
     pool->free_head = pool->slots[index].next_free_index;
     pool->slots[index].generation++;
     pool->slots[index].active = 1;
+    pool->active_pos[index] = pool->active_count;
+    pool->active_list[pool->active_count] = index;
+    agent_mark_position_dirty(pool, pool->active_count);
     pool->active_count++;
     AgentID id = make_agent_id(index, pool->slots[index].generation);
     pool->slots[index].id = id;
@@ -82,16 +111,31 @@ AgentID agent_pool_allocate(AgentPool *pool)
 
 void agent_pool_free(AgentPool *pool, AgentID id)
 {
-    uint16_t index = agent_index(id);
+    AgentIndex index = agent_index(id);
+    if (index >= pool->capacity || !pool->slots[index].active)
+        return;
+
+    agent_set_state(pool, &pool->slots[index], STATE_IDLE);
+
+    // swap-remove from the dense list, the last live slot takes our position
+    uint32_t pos = pool->active_pos[index];
+    uint32_t last = pool->active_list[pool->active_count - 1];
+    pool->active_list[pos] = last;
+    pool->active_pos[last] = pos;
+
     pool->slots[index].active = 0;
     pool->slots[index].next_free_index = pool->free_head;
     pool->active_count--;
     pool->free_head = index;
+
+    // the entry at pos now shows the moved agent; a shrunk tail needs nothing
+    if (pos < pool->active_count)
+        agent_mark_position_dirty(pool, pos);
 }
 
 AgentSlot *agent_pool_get(AgentPool *pool, AgentID id)
 {
-    uint16_t index = agent_index(id);
+    AgentIndex index = agent_index(id);
     if (index >= pool->capacity)
         return NULL;
 
@@ -105,3 +149,31 @@ AgentSlot *agent_pool_get(AgentPool *pool, AgentID id)
 
     return slot->active ? slot : NULL;
 }
+
+void agent_set_state(AgentPool *pool, AgentSlot *agent, uint8_t state)
+{
+    if (agent->state == state)
+        return;
+
+    uint32_t index = agent_index(agent->id);
+
+    if (agent->state != STATE_IDLE && agent->state < PATIKA_AGENT_STATE_COUNT)
+    {
+        AgentStateList *list = &pool->state_lists[agent->state];
+        uint32_t pos = pool->state_pos[index];
+        uint32_t last = list->indices[--list->count];
+        list->indices[pos] = last;
+        pool->state_pos[last] = pos;
+    }
+
+    if (state != STATE_IDLE && state < PATIKA_AGENT_STATE_COUNT)
+    {
+        AgentStateList *list = &pool->state_lists[state];
+        pool->state_pos[index] = list->count;
+        list->indices[list->count++] = index;
+    }
+
+    agent->state = state;
+    if (agent->active)
+        agent_mark_dirty(pool, agent);
+}
@@ -0,0 +1,132 @@
+#include "internal/patika_internal.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Typed event record ring.
+ *
+ * PatikaEvent is one fixed size; records are a header plus a body of their
+ * own type's size, so small events stay small and richer ones (interaction
+ * target, barrack) need no side channel. Positions count bytes and wrap
+ * with uint32_t arithmetic. A record never straddles the end of the buffer:
+ * when it does not fit before the end, the producer leaves a pad header and
+ * starts over at offset 0, and the reader skips to offset 0 on seeing it.
+ * Every record size is a multiple of 8, so a header always fits before the
+ * end and bodies stay 8-byte aligned.
+ */
+
+#define RECORD_PAD 0xFFFFu
+#define RECORD_RING_MIN 256u
+#define RECORD_RING_MAX (1u << 30)
+
+void record_ring_init(EventRecordRing *r, uint32_t capacity) {
+  memset(r, 0, sizeof(*r));
+  if (!capacity) {
+    return;
+  }
+  uint32_t size = RECORD_RING_MIN;
+  while (size < capacity && size < RECORD_RING_MAX)
+    size <<= 1;
+
+  r->buffer = malloc(size);
+  if (!r->buffer) {
+    PATIKA_INTERNAL_LOG_ERROR("Failed to allocate %u byte event record ring", size);
+    return;
+  }
+  r->capacity = size;
+  r->mask = size - 1;
+  atomic_init(&r->head, 0);
+  atomic_init(&r->tail, 0);
+}
+
+void record_ring_destroy(EventRecordRing *r) {
+  free(r->buffer);
+  r->buffer = NULL;
+  r->capacity = 0;
+}
+
+static int record_ring_push(EventRecordRing *r, uint16_t type, uint32_t tick,
+                            const void *body, uint32_t body_size) {
+  uint32_t size = PATIKA_RECORD_SIZE(body_size);
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+  uint32_t offset = head & r->mask;
+  uint32_t skip = r->capacity - offset < size ? r->capacity - offset : 0;
+
+  if (r->capacity - (head - tail) < skip + size) {
+    return 0;
+  }
+  if (skip) {
+    PatikaEventRecord *pad = (PatikaEventRecord *)(r->buffer + offset);
+    pad->type = RECORD_PAD;
+    pad->size = 0;
+    pad->tick = tick;
+    head += skip;
+    offset = 0;
+  }
+
+  PatikaEventRecord *rec = (PatikaEventRecord *)(r->buffer + offset);
+  rec->type = type;
+  rec->size = (uint16_t)size;
+  rec->tick = tick;
+  memcpy(rec + 1, body, body_size);
+  memset((uint8_t *)(rec + 1) + body_size, 0, size - sizeof(*rec) - body_size);
+
+  atomic_store_explicit(&r->head, head + size, memory_order_release);
+  return 1;
+}
+
+void emit_record(struct PatikaContext *ctx, uint16_t type, const void *body,
+                 uint32_t body_size) {
+  EventRecordRing *r = &ctx->records;
+  if (!r->capacity) {
+    return;
+  }
+  uint32_t tick = (uint32_t)ctx->stats.total_ticks;
+
+  if (r->pending_lost) {
+    PatikaOverflowRecord lost = {
+        r->pending_lost > UINT32_MAX ? UINT32_MAX : (uint32_t)r->pending_lost};
+    if (!record_ring_push(r, EVENT_OVERFLOW, tick, &lost, sizeof(lost))) {
+      r->pending_lost++;
+      ctx->stats.event_records_dropped++;
+      return;
+    }
+    r->pending_lost = 0;
+  }
+
+  if (!record_ring_push(r, type, tick, body, body_size)) {
+    r->pending_lost++;
+    ctx->stats.event_records_dropped++;
+  }
+}
+
+PATIKA_API uint32_t patika_poll_event_records(PatikaHandle handle, void *out,
+                                              uint32_t capacity) {
+  if (!handle || !out || !handle->records.capacity) {
+    return 0;
+  }
+  EventRecordRing *r = &handle->records;
+  uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+
+  uint32_t written = 0;
+  while (tail != head) {
+    uint32_t offset = tail & r->mask;
+    const PatikaEventRecord *rec = (const PatikaEventRecord *)(r->buffer + offset);
+    if (rec->type == RECORD_PAD) {
+      tail += r->capacity - offset;
+      continue;
+    }
+    if (capacity - written < rec->size) {
+      break;
+    }
+    memcpy((uint8_t *)out + written, rec, rec->size);
+    written += rec->size;
+    tail += rec->size;
+  }
+
+  atomic_store_explicit(&r->tail, tail, memory_order_release);
+  return written;
+}
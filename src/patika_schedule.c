@@ -0,0 +1,182 @@
+#include "internal/patika_internal.h"
+#include <string.h>
+
+/*
+ * Hierarchical timing wheel for commands scheduled at a future tick.
+ *
+ * Level L holds commands whose target tick differs from the current tick in
+ * no byte above byte L, in slot (tick >> 8L) & 255. Level 0 slots therefore hold
+ * exactly the commands due on that tick. Whenever the current tick enters a
+ * new block of 256^L ticks, the matching level L slot is re-filed into the
+ * lower levels. Insertion and expiry are O(1), and each command cascades at
+ * most once per level. Slots are FIFO lists, so commands due on the same
+ * tick fire in the order they were scheduled.
+ */
+
+static void wheel_list_push(ScheduleList *list, ScheduledCommand *node)
+{
+    node->next = NULL;
+    if (list->tail)
+        list->tail->next = node;
+    else
+        list->head = node;
+    list->tail = node;
+}
+
+static ScheduledCommand *wheel_list_take(ScheduleList *list)
+{
+    ScheduledCommand *head = list->head;
+    list->head = NULL;
+    list->tail = NULL;
+    return head;
+}
+
+static void wheel_file(TimingWheel *w, ScheduledCommand *node)
+{
+    uint64_t delta = node->tick ^ w->now;
+    for (uint32_t level = 0; level < PATIKA_WHEEL_LEVELS; level++)
+    {
+        uint32_t shift = PATIKA_WHEEL_BITS * (level + 1);
+        if ((delta >> shift) == 0)
+        {
+            uint32_t slot = (uint32_t)(node->tick >> (PATIKA_WHEEL_BITS * level)) & (PATIKA_WHEEL_SLOTS - 1);
+            wheel_list_push(&w->slots[level][slot], node);
+            return;
+        }
+    }
+    wheel_list_push(&w->overflow, node); // beyond 2^32 ticks, re-filed on wrap
+}
+
+/* advance to tick now + 1, cascading every level whose block just started */
+static void wheel_step(TimingWheel *w)
+{
+    w->now++;
+
+    uint32_t top = 0;
+    while (top < PATIKA_WHEEL_LEVELS &&
+           ((w->now >> (PATIKA_WHEEL_BITS * top)) & (PATIKA_WHEEL_SLOTS - 1)) == 0)
+    {
+        top++;
+    }
+
+    ScheduledCommand *node = NULL;
+    if (top == PATIKA_WHEEL_LEVELS)
+    {
+        node = wheel_list_take(&w->overflow);
+        top--;
+    }
+    for (uint32_t level = top; level > 0; level--)
+    {
+        uint32_t slot = (uint32_t)(w->now >> (PATIKA_WHEEL_BITS * level)) & (PATIKA_WHEEL_SLOTS - 1);
+        // overflow first: it was filed against an older block than any slot
+        ScheduledCommand *pending = node;
+        while (pending)
+        {
+            ScheduledCommand *next = pending->next;
+            wheel_file(w, pending);
+            pending = next;
+        }
+        node = wheel_list_take(&w->slots[level][slot]);
+    }
+    while (node)
+    {
+        ScheduledCommand *next = node->next;
+        wheel_file(w, node);
+        node = next;
+    }
+}
+
+void schedule_insert(struct PatikaContext *ctx, ScheduledCommand *node)
+{
+    TimingWheel *w = &ctx->wheel;
+    if (node->tick <= w->now)
+    {
+        // due this tick or already past: run once the batch is done rather
+        // than drop it, so it does not cut into the sorted batch
+        wheel_list_push(&w->late, node);
+        return;
+    }
+    wheel_file(w, node);
+    w->pending++;
+}
+
+void schedule_fire(struct PatikaContext *ctx, uint64_t tick)
+{
+    TimingWheel *w = &ctx->wheel;
+    while (w->now < tick)
+        wheel_step(w);
+
+    ScheduledCommand *node = wheel_list_take(&w->slots[0][w->now & (PATIKA_WHEEL_SLOTS - 1)]);
+    while (node)
+    {
+        ScheduledCommand *next = node->next;
+        w->pending--;
+        process_command(ctx, &node->cmd);
+        payload_pool_release(node);
+        node = next;
+    }
+}
+
+void schedule_run_late(struct PatikaContext *ctx)
+{
+    ScheduledCommand *node;
+    while ((node = wheel_list_take(&ctx->wheel.late)) != NULL)
+    {
+        while (node)
+        {
+            ScheduledCommand *next = node->next;
+            process_command(ctx, &node->cmd);
+            payload_pool_release(node);
+            node = next;
+        }
+    }
+}
+
+static void schedule_release_list(ScheduledCommand *node)
+{
+    while (node)
+    {
+        ScheduledCommand *next = node->next;
+        if (command_has_payload(node->cmd.type))
+            command_release_payload(&node->cmd);
+        payload_pool_release(node);
+        node = next;
+    }
+}
+
+void schedule_destroy(TimingWheel *w)
+{
+    for (uint32_t level = 0; level < PATIKA_WHEEL_LEVELS; level++)
+    {
+        for (uint32_t slot = 0; slot < PATIKA_WHEEL_SLOTS; slot++)
+            schedule_release_list(wheel_list_take(&w->slots[level][slot]));
+    }
+    schedule_release_list(wheel_list_take(&w->overflow));
+    schedule_release_list(wheel_list_take(&w->late));
+    w->pending = 0;
+}
+
+PATIKA_API PatikaError patika_schedule_command(PatikaHandle handle, const PatikaCommand *cmd, uint64_t execute_at_tick)
+{
+    if (!handle || !cmd)
+        return PATIKA_ERR_NULL_HANDLE;
+
+    ScheduledCommand *node = payload_pool_alloc(&handle->payloads, sizeof(ScheduledCommand));
+    if (!node)
+        return PATIKA_ERR_CAPACITY;
+    node->next = NULL;
+    node->tick = execute_at_tick;
+    node->cmd = *cmd;
+
+    PatikaCommand wrapper;
+    memset(&wrapper, 0, sizeof(wrapper));
+    wrapper.type = CMD_SCHEDULE;
+    wrapper.flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+    wrapper.large_command.payload = node;
+    if (mpsc_push(&handle->cmd_queue, &wrapper) != 0)
+    {
+        payload_pool_release(node);
+        return PATIKA_ERR_QUEUE_FULL;
+    }
+    return PATIKA_OK;
+}
@@ -1,20 +1,96 @@
 #include "internal/patika_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_COLUMN_ALIGN 64u
+
+static size_t column_size(size_t bytes)
+{
+    return (bytes + SNAPSHOT_COLUMN_ALIGN - 1) & ~(size_t)(SNAPSHOT_COLUMN_ALIGN - 1);
+}
+
+void *snapshot_columns_alloc(PatikaAgentColumns *columns, uint32_t capacity)
+{
+    size_t id_bytes = column_size((size_t)capacity * sizeof(AgentID));
+    size_t pos_bytes = column_size((size_t)capacity * sizeof(int32_t));
+    size_t tag_bytes = column_size(capacity);
+
+    uint8_t *block = calloc(1, id_bytes + 2 * pos_bytes + 2 * tag_bytes + SNAPSHOT_COLUMN_ALIGN);
+    if (!block)
+    {
+        PATIKA_INTERNAL_LOG_ERROR("Failed to allocate snapshot columns for %u agents", capacity);
+        return NULL;
+    }
+
+    uint8_t *p = block + (SNAPSHOT_COLUMN_ALIGN - (uintptr_t)block % SNAPSHOT_COLUMN_ALIGN) % SNAPSHOT_COLUMN_ALIGN;
+    columns->id = (AgentID *)p;
+    p += id_bytes;
+    columns->pos_q = (int32_t *)p;
+    p += pos_bytes;
+    columns->pos_r = (int32_t *)p;
+    p += pos_bytes;
+    columns->state = p;
+    p += tag_bytes;
+    columns->faction = p;
+    return block;
+}
+
+/**
+ * @brief Oldest buffer that is neither published nor pinned by a reader
+ * @return PATIKA_SNAPSHOT_BUFFERS when readers hold every spare one
+ */
+static uint32_t snapshot_free_buffer(struct PatikaContext *ctx)
+{
+    uint32_t published = atomic_load(&ctx->snapshot_index);
+    for (uint32_t n = 1; n < PATIKA_SNAPSHOT_BUFFERS; n++)
+    {
+        uint32_t idx = (published + n) % PATIKA_SNAPSHOT_BUFFERS;
+        if (atomic_load(&ctx->snapshot_pins[idx]) == 0)
+            return idx;
+    }
+    return PATIKA_SNAPSHOT_BUFFERS;
+}
 
 void update_snapshot(struct PatikaContext *ctx)
 {
-    uint32_t idx = (atomic_load(&ctx->snapshot_index) + 1) % 2;
+    uint32_t idx = snapshot_free_buffer(ctx);
+    if (idx == PATIKA_SNAPSHOT_BUFFERS)
+    {
+        // never wait on readers: keep the published snapshot one more tick
+        ctx->stats.snapshots_skipped++;
+        ctx->stats.snapshot_entries_copied = 0;
+        return;
+    }
     PatikaSnapshot *snap = &ctx->snapshots[idx];
 
-    uint32_t agent_count = 0;
+    /* Only entries changed since this buffer was last written are copied;
+     * the rest already match. Entries past active_count are not shown. */
+    AgentPool *pool = &ctx->agents;
+    SnapshotDirtyList *dirty = &pool->snapshot_dirty[idx];
+    uint32_t copied = 0;
     uint16_t barrack_count = 0;
-    snap->agent_count = ctx->agents.active_count;
-    for (uint32_t i = 0; i < ctx->agents.capacity; i++)
+    snap->agent_count = pool->active_count;
+    for (uint32_t d = 0; d < dirty->count; d++)
     {
-        AgentSlot *slot = &ctx->agents.slots[i];
-        if (!slot->active)
+        uint32_t i = dirty->positions[d];
+        dirty->marked[i] = 0;
+        if (i >= pool->active_count)
             continue;
 
-        AgentSnapshot *a = &snap->agents[agent_count++];
+        AgentSlot *slot = &pool->slots[pool->active_list[i]];
+        copied++;
+        if (ctx->config.snapshot_soa)
+        {
+            PatikaAgentColumns *c = &snap->columns;
+            c->id[i] = slot->id;
+            c->pos_q[i] = slot->pos_q;
+            c->pos_r[i] = slot->pos_r;
+            c->state[i] = slot->state;
+            c->faction[i] = slot->faction;
+            continue;
+        }
+
+        AgentSnapshot *a = &snap->agents[i];
         a->id = slot->id;
         a->state = slot->state;
         a->faction = slot->faction;
@@ -27,6 +103,9 @@ void update_snapshot(struct PatikaContext *ctx)
         a->target_q = slot->target_q;
         a->target_r = slot->target_r;
     }
+    dirty->count = 0;
+    ctx->stats.snapshot_entries_copied = copied;
+
     for (uint16_t i = 0; i < ctx->barracks.next_id; i++)
     {
         BarrackSlot *slot = &ctx->barracks.slots[i];
@@ -48,3 +127,39 @@ void update_snapshot(struct PatikaContext *ctx)
     snap->version = atomic_fetch_add(&ctx->version, 1) + 1;
     atomic_store(&ctx->snapshot_index, idx);
 }
+
+void movement_deltas_init(MovementDeltas *d, uint32_t capacity)
+{
+    memset(d, 0, sizeof(*d));
+    d->records[0] = calloc(capacity, sizeof(PatikaMovementDelta));
+    d->records[1] = calloc(capacity, sizeof(PatikaMovementDelta));
+    if (!d->records[0] || !d->records[1])
+    {
+        PATIKA_LOG_ERROR("movement deltas: allocation failed, disabled");
+        movement_deltas_destroy(d);
+        return;
+    }
+    d->views[0].deltas = d->records[0];
+    d->views[1].deltas = d->records[1];
+    d->capacity = capacity;
+    d->write = 1;
+    atomic_init(&d->published, 0);
+}
+
+void movement_deltas_destroy(MovementDeltas *d)
+{
+    free(d->records[0]);
+    free(d->records[1]);
+    memset(d, 0, sizeof(*d));
+}
+
+void movement_deltas_publish(MovementDeltas *d, uint64_t tick)
+{
+    if (!d->capacity)
+        return;
+
+    d->views[d->write].tick = tick;
+    atomic_store(&d->published, d->write);
+    d->write ^= 1;
+    d->views[d->write].count = 0;
+}
@@ -1,6 +1,7 @@
 #include "internal/patika_internal.h"
 #include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
 
 void spsc_init(SPSCEventQueue *q, uint32_t capacity) {
   q->buffer = calloc(capacity, sizeof(PatikaEvent));
@@ -55,3 +56,59 @@ PatikaError spsc_pop(SPSCEventQueue *q, PatikaEvent *out) {
 
   return PATIKA_OK; // SUCCESS
 }
+
+/**
+ * @brief Readable events as up to two contiguous runs (single consumer only).
+ * @details Loads head once; the runs stay valid until spsc_commit.
+ * @return Total events in both runs, at most max.
+ */
+uint32_t spsc_peek(SPSCEventQueue *q, uint32_t max, SPSCSpan *out) {
+  uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+  uint32_t first = head >= tail ? head - tail : q->capacity - tail;
+  uint32_t second = head >= tail ? 0 : head;
+  if (first > max) {
+    first = max;
+  }
+  if (second > max - first) {
+    second = max - first;
+  }
+
+  out->first = &q->buffer[tail];
+  out->first_count = first;
+  out->second = q->buffer;
+  out->second_count = second;
+  return first + second;
+}
+
+/**
+ * @brief Releases count peeked events back to the producer (single consumer only).
+ */
+void spsc_commit(SPSCEventQueue *q, uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+  uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  atomic_store_explicit(&q->tail, (tail + count) % q->capacity,
+                        memory_order_release);
+}
+
+/**
+ * @brief Pops up to max events with one head load and one tail store
+ *        (single consumer only).
+ * @return Number of events copied to out.
+ */
+uint32_t spsc_pop_bulk(SPSCEventQueue *q, PatikaEvent *out, uint32_t max) {
+  SPSCSpan span;
+  uint32_t count = spsc_peek(q, max, &span);
+  if (count == 0) {
+    return 0;
+  }
+
+  memcpy(out, span.first, span.first_count * sizeof(PatikaEvent));
+  memcpy(out + span.first_count, span.second,
+         span.second_count * sizeof(PatikaEvent));
+  spsc_commit(q, count);
+  return count;
+}
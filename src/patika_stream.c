@@ -0,0 +1,427 @@
+#include "internal/patika_internal.h"
+#include <string.h>
+
+/*
+ * Binary command stream (format in include/patika/stream.h).
+ *
+ * patika_submit_stream validates the whole buffer first, then reserves one
+ * queue slot per record in a single reservation and decodes every record
+ * straight into its slot. Payload-carrying records take their payload from
+ * the caller's slab, so steady-state ingestion does not touch malloc.
+ */
+
+#define SPAWN_RECORD_SIZE 16
+
+static inline uint16_t rd_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t rd_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t rd_u64(const uint8_t *p)
+{
+    return (uint64_t)rd_u32(p) | ((uint64_t)rd_u32(p + 4) << 32);
+}
+
+static inline void wr_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void wr_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void wr_u64(uint8_t *p, uint64_t v)
+{
+    wr_u32(p, (uint32_t)v);
+    wr_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline AgentID rd_agent_id(const uint8_t *p)
+{
+#ifdef PATIKA_WIDE_AGENT_IDS
+    return rd_u64(p);
+#else
+    return rd_u32(p);
+#endif
+}
+
+static inline void wr_agent_id(uint8_t *p, AgentID id)
+{
+#ifdef PATIKA_WIDE_AGENT_IDS
+    wr_u64(p, id);
+#else
+    wr_u32(p, id);
+#endif
+}
+
+#define AGENT_ID_SIZE ((uint32_t)sizeof(AgentID))
+
+/* body length for a type, 0 for types without an encoding; bulk is variable */
+static uint32_t record_body_size(uint16_t type)
+{
+    switch (type)
+    {
+    case CMD_SET_GOAL:                return AGENT_ID_SIZE + 8;
+    case CMD_REMOVE_AGENT:            return AGENT_ID_SIZE;
+    case CMD_SET_TILE_STATE:          return 12;
+    case CMD_ADD_AGENT:               return SPAWN_RECORD_SIZE;
+    case CMD_ADD_AGENT_WITH_BEHAVIOR: return SPAWN_RECORD_SIZE + 16;
+    case CMD_ADD_BARRACK:             return 16;
+    default:                          return 0;
+    }
+}
+
+PatikaError stream_validate_records(const uint8_t *p, size_t len, uint32_t *out_count)
+{
+    uint32_t count = 0;
+    size_t pos = 0;
+    while (pos < len)
+    {
+        if (len - pos < PATIKA_STREAM_RECORD_HEADER_SIZE)
+            return PATIKA_ERR_BAD_STREAM;
+
+        uint16_t type = rd_u16(p + pos);
+        uint32_t body = rd_u32(p + pos + 4);
+        pos += PATIKA_STREAM_RECORD_HEADER_SIZE;
+        if (rd_u16(p + pos - 6) != 0 || body > len - pos)
+            return PATIKA_ERR_BAD_STREAM;
+
+        if (type == CMD_ADD_AGENTS_BULK)
+        {
+            if (body < 4 || (uint64_t)rd_u32(p + pos) * SPAWN_RECORD_SIZE != body - 4)
+                return PATIKA_ERR_BAD_STREAM;
+        }
+        else
+        {
+            uint32_t expected = record_body_size(type);
+            if (expected == 0)
+                return PATIKA_ERR_INVALID_COMMAND_TYPE;
+            if (body != expected)
+                return PATIKA_ERR_BAD_STREAM;
+        }
+
+        pos += body;
+        count++;
+    }
+    *out_count = count;
+    return PATIKA_OK;
+}
+
+PatikaError stream_check_header(const uint8_t *p, size_t len)
+{
+    if (len < PATIKA_STREAM_HEADER_SIZE || rd_u32(p) != PATIKA_STREAM_MAGIC ||
+        p[4] != PATIKA_STREAM_VERSION || rd_u16(p + 6) != 0)
+        return PATIKA_ERR_BAD_STREAM;
+
+#ifdef PATIKA_WIDE_AGENT_IDS
+    uint8_t expected_flags = PATIKA_STREAM_FLAG_WIDE_AGENT_IDS;
+#else
+    uint8_t expected_flags = 0;
+#endif
+    return p[5] == expected_flags ? PATIKA_OK : PATIKA_ERR_BAD_STREAM;
+}
+
+static void decode_spawn(const uint8_t *p, PatikaSpawnRecord *rec)
+{
+    rec->start_q = (int32_t)rd_u32(p);
+    rec->start_r = (int32_t)rd_u32(p + 4);
+    rec->faction = p[8];
+    rec->side = p[9];
+    rec->parent_barrack = rd_u16(p + 10);
+    rec->collision_data.layer = p[12];
+    rec->collision_data.collision_mask = p[13];
+    rec->collision_data.aggression_mask = p[14];
+}
+
+static void encode_spawn(uint8_t *p, const PatikaSpawnRecord *rec)
+{
+    wr_u32(p, (uint32_t)rec->start_q);
+    wr_u32(p + 4, (uint32_t)rec->start_r);
+    p[8] = rec->faction;
+    p[9] = rec->side;
+    wr_u16(p + 10, rec->parent_barrack);
+    p[12] = rec->collision_data.layer;
+    p[13] = rec->collision_data.collision_mask;
+    p[14] = rec->collision_data.aggression_mask;
+    p[15] = 0;
+}
+
+const uint8_t *stream_decode_record(PayloadPool *payloads, const uint8_t *p, PatikaCommand *out)
+{
+    uint16_t type = rd_u16(p);
+    uint32_t body_len = rd_u32(p + 4);
+    const uint8_t *body = p + PATIKA_STREAM_RECORD_HEADER_SIZE;
+
+    memset(out, 0, sizeof(*out));
+    out->type = (CommandType)type;
+
+    switch (type)
+    {
+    case CMD_SET_GOAL:
+        out->set_goal.agent_id = rd_agent_id(body);
+        out->set_goal.goal_q = (int32_t)rd_u32(body + AGENT_ID_SIZE);
+        out->set_goal.goal_r = (int32_t)rd_u32(body + AGENT_ID_SIZE + 4);
+        break;
+
+    case CMD_REMOVE_AGENT:
+        out->remove_agent.agent_id = rd_agent_id(body);
+        break;
+
+    case CMD_SET_TILE_STATE:
+        out->set_tile.q = (int32_t)rd_u32(body);
+        out->set_tile.r = (int32_t)rd_u32(body + 4);
+        out->set_tile.state = body[8];
+        break;
+
+    /* a NULL payload after a failed allocation is logged and skipped by
+     * the handler; the slot is already reserved and must carry something */
+    case CMD_ADD_AGENT:
+    {
+        AddAgentPayload *payload = payload_pool_alloc(payloads, sizeof(AddAgentPayload));
+        if (payload)
+        {
+            PatikaSpawnRecord rec;
+            decode_spawn(body, &rec);
+            payload->start_q = rec.start_q;
+            payload->start_r = rec.start_r;
+            payload->faction = rec.faction;
+            payload->side = rec.side;
+            payload->parent_barrack = rec.parent_barrack;
+            payload->collision_data = rec.collision_data;
+            payload->out_agent_id = NULL;
+        }
+        out->flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+        out->large_command.payload = payload;
+        break;
+    }
+
+    case CMD_ADD_AGENT_WITH_BEHAVIOR:
+    {
+        AddAgentWithBehaviorPayload *payload =
+            payload_pool_alloc(payloads, sizeof(AddAgentWithBehaviorPayload));
+        if (payload)
+        {
+            memset(payload, 0, sizeof(*payload));
+            PatikaSpawnRecord rec;
+            decode_spawn(body, &rec);
+            payload->start_q = rec.start_q;
+            payload->start_r = rec.start_r;
+            payload->faction = rec.faction;
+            payload->side = rec.side;
+            payload->parent_barrack = rec.parent_barrack;
+            payload->collision_data = rec.collision_data;
+            payload->initial_behavior = (AgentBehavior)body[16];
+            if (payload->initial_behavior == BEHAVIOR_EXPLORE)
+            {
+                payload->behavior_params.explore.mode = (int32_t)rd_u32(body + 20);
+            }
+            else
+            {
+                payload->behavior_params.patrol.center_q = (int32_t)rd_u32(body + 20);
+                payload->behavior_params.patrol.center_r = (int32_t)rd_u32(body + 24);
+                payload->behavior_params.patrol.radius = (int32_t)rd_u32(body + 28);
+            }
+        }
+        out->flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+        out->large_command.payload = payload;
+        break;
+    }
+
+    case CMD_ADD_AGENTS_BULK:
+    {
+        uint32_t count = rd_u32(body);
+        PatikaSpawnRecord *records =
+            count ? payload_pool_alloc(payloads, (size_t)count * sizeof(PatikaSpawnRecord)) : NULL;
+        if (records)
+        {
+            for (uint32_t i = 0; i < count; i++)
+                decode_spawn(body + 4 + (size_t)i * SPAWN_RECORD_SIZE, &records[i]);
+        }
+        out->flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+        out->add_agents_bulk.records = records;
+        out->add_agents_bulk.count = records ? count : 0;
+        break;
+    }
+
+    case CMD_ADD_BARRACK:
+    {
+        AddBarrackPayload *payload = payload_pool_alloc(payloads, sizeof(AddBarrackPayload));
+        if (payload)
+        {
+            payload->pos_q = (int32_t)rd_u32(body);
+            payload->pos_r = (int32_t)rd_u32(body + 4);
+            payload->faction = body[8];
+            payload->side = body[9];
+            payload->behavior = body[10];
+            payload->patrol_radius = body[11];
+            payload->max_agents = rd_u16(body + 12);
+            payload->out_barrack_id = NULL;
+        }
+        out->flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+        out->large_command.payload = payload;
+        break;
+    }
+    }
+
+    return body + body_len;
+}
+
+PATIKA_API size_t patika_stream_write_header(uint8_t *out, size_t capacity)
+{
+    if (!out || capacity < PATIKA_STREAM_HEADER_SIZE)
+        return 0;
+    wr_u32(out, PATIKA_STREAM_MAGIC);
+    out[4] = PATIKA_STREAM_VERSION;
+#ifdef PATIKA_WIDE_AGENT_IDS
+    out[5] = PATIKA_STREAM_FLAG_WIDE_AGENT_IDS;
+#else
+    out[5] = 0;
+#endif
+    wr_u16(out + 6, 0);
+    return PATIKA_STREAM_HEADER_SIZE;
+}
+
+size_t stream_encoded_size(const PatikaCommand *cmd)
+{
+    if (cmd->type == CMD_ADD_AGENTS_BULK)
+    {
+        if (cmd->add_agents_bulk.count && !cmd->add_agents_bulk.records)
+            return 0;
+        return PATIKA_STREAM_RECORD_HEADER_SIZE + 4 +
+               (size_t)cmd->add_agents_bulk.count * SPAWN_RECORD_SIZE;
+    }
+    if ((uint32_t)cmd->type > 0xFFFFu)
+        return 0;
+    uint32_t body_len = record_body_size((uint16_t)cmd->type);
+    if (body_len == 0 || (command_has_payload(cmd->type) && !cmd->large_command.payload))
+        return 0;
+    return PATIKA_STREAM_RECORD_HEADER_SIZE + body_len;
+}
+
+PATIKA_API size_t patika_stream_encode(const PatikaCommand *cmd, uint8_t *out, size_t capacity)
+{
+    if (!cmd || !out)
+        return 0;
+
+    size_t size = stream_encoded_size(cmd);
+    if (size == 0 || size > capacity || size - PATIKA_STREAM_RECORD_HEADER_SIZE > UINT32_MAX)
+        return 0;
+    uint32_t body_len = (uint32_t)(size - PATIKA_STREAM_RECORD_HEADER_SIZE);
+
+    uint8_t *body = out + PATIKA_STREAM_RECORD_HEADER_SIZE;
+    memset(out, 0, size);
+    wr_u16(out, (uint16_t)cmd->type);
+    wr_u32(out + 4, body_len);
+
+    switch (cmd->type)
+    {
+    case CMD_SET_GOAL:
+        wr_agent_id(body, cmd->set_goal.agent_id);
+        wr_u32(body + AGENT_ID_SIZE, (uint32_t)cmd->set_goal.goal_q);
+        wr_u32(body + AGENT_ID_SIZE + 4, (uint32_t)cmd->set_goal.goal_r);
+        break;
+
+    case CMD_REMOVE_AGENT:
+        wr_agent_id(body, cmd->remove_agent.agent_id);
+        break;
+
+    case CMD_SET_TILE_STATE:
+        wr_u32(body, (uint32_t)cmd->set_tile.q);
+        wr_u32(body + 4, (uint32_t)cmd->set_tile.r);
+        body[8] = cmd->set_tile.state;
+        break;
+
+    case CMD_ADD_AGENT:
+    {
+        const AddAgentPayload *payload = cmd->large_command.payload;
+        PatikaSpawnRecord rec = {payload->start_q, payload->start_r, payload->faction,
+                                 payload->side, payload->parent_barrack, payload->collision_data};
+        encode_spawn(body, &rec);
+        break;
+    }
+
+    case CMD_ADD_AGENT_WITH_BEHAVIOR:
+    {
+        const AddAgentWithBehaviorPayload *payload = cmd->large_command.payload;
+        PatikaSpawnRecord rec = {payload->start_q, payload->start_r, payload->faction,
+                                 payload->side, payload->parent_barrack, payload->collision_data};
+        encode_spawn(body, &rec);
+        body[16] = (uint8_t)payload->initial_behavior;
+        if (payload->initial_behavior == BEHAVIOR_EXPLORE)
+        {
+            wr_u32(body + 20, (uint32_t)payload->behavior_params.explore.mode);
+        }
+        else
+        {
+            wr_u32(body + 20, (uint32_t)payload->behavior_params.patrol.center_q);
+            wr_u32(body + 24, (uint32_t)payload->behavior_params.patrol.center_r);
+            wr_u32(body + 28, (uint32_t)payload->behavior_params.patrol.radius);
+        }
+        break;
+    }
+
+    case CMD_ADD_AGENTS_BULK:
+        wr_u32(body, cmd->add_agents_bulk.count);
+        for (uint32_t i = 0; i < cmd->add_agents_bulk.count; i++)
+            encode_spawn(body + 4 + (size_t)i * SPAWN_RECORD_SIZE, &cmd->add_agents_bulk.records[i]);
+        break;
+
+    case CMD_ADD_BARRACK:
+    {
+        const AddBarrackPayload *payload = cmd->large_command.payload;
+        wr_u32(body, (uint32_t)payload->pos_q);
+        wr_u32(body + 4, (uint32_t)payload->pos_r);
+        body[8] = payload->faction;
+        body[9] = payload->side;
+        body[10] = payload->behavior;
+        body[11] = payload->patrol_radius;
+        wr_u16(body + 12, payload->max_agents);
+        break;
+    }
+
+    default:
+        return 0;
+    }
+
+    return PATIKA_STREAM_RECORD_HEADER_SIZE + (size_t)body_len;
+}
+
+PATIKA_API PatikaError patika_submit_stream(PatikaHandle handle, const void *bytes, size_t len)
+{
+    if (!handle || !bytes)
+        return PATIKA_ERR_NULL_HANDLE;
+
+    const uint8_t *p = (const uint8_t *)bytes;
+    PatikaError err = stream_check_header(p, len);
+    if (err != PATIKA_OK)
+        return err;
+    p += PATIKA_STREAM_HEADER_SIZE;
+    len -= PATIKA_STREAM_HEADER_SIZE;
+
+    uint32_t count;
+    err = stream_validate_records(p, len, &count);
+    if (err != PATIKA_OK || count == 0)
+        return err;
+
+    MPSCCommandQueue *q = &handle->cmd_queue;
+    uint32_t pos;
+    if (count > q->capacity || mpsc_reserve(q, count, count, &pos) != count)
+        return PATIKA_ERR_QUEUE_FULL;
+
+    for (uint32_t i = 0; i < count; i++)
+        p = stream_decode_record(&handle->payloads, p, mpsc_slot_command(q, pos + i));
+
+    mpsc_publish(q, pos, count);
+    return PATIKA_OK;
+}
@@ -1,9 +1,9 @@
 #include "internal/patika_internal.h"
 #include "patika.h"
 
-static inline AgentID map_get_agent_id(uint32_t grid_value)
+static inline AgentIndex map_get_agent_id(uint32_t grid_value)
 {
-    return grid_value & AGENT_GRID_AGENT_MASK;
+    return (AgentIndex)(grid_value & AGENT_GRID_AGENT_MASK);
 }
 
 static inline int is_tile_reserved(uint32_t grid_value)
@@ -13,7 +13,7 @@ static inline int is_tile_reserved(uint32_t grid_value)
 
 static inline int is_tile_occupied(uint32_t grid_value)
 {
-    AgentID id = map_get_agent_id(grid_value);
-    return id != PATIKA_INVALID_AGENT_ID && !(grid_value & AGENT_GRID_RESERVED_BIT);
+    AgentIndex id = map_get_agent_id(grid_value);
+    return id != PATIKA_INVALID_AGENT_INDEX && !(grid_value & AGENT_GRID_RESERVED_BIT);
 }
 
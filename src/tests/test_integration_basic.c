@@ -197,6 +197,219 @@ void test_snapshot_version_increments(void) {
     TEST_ASSERT_TRUE(v2 > v1);
 }
 
+void test_agent_reaches_goal(void) {
+    AgentID agent_id = PATIKA_INVALID_AGENT_ID;
+    AddAgentPayload *payload = malloc(sizeof(AddAgentPayload));
+    payload->start_q = 0;
+    payload->start_r = 0;
+    payload->faction = 0;
+    payload->side = 0;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    payload->out_agent_id = &agent_id;
+    payload->collision_data.layer = 0;
+    payload->collision_data.collision_mask = 0;
+    payload->collision_data.aggression_mask = 0;
+    
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENT;
+    cmd.large_command.payload = payload;
+    patika_submit_command(ctx, &cmd);
+    patika_tick(ctx);
+    
+    PatikaCommand goal_cmd = {0};
+    goal_cmd.type = CMD_SET_GOAL;
+    goal_cmd.set_goal.agent_id = agent_id;
+    goal_cmd.set_goal.goal_q = 3;
+    goal_cmd.set_goal.goal_r = 0;
+    patika_submit_command(ctx, &goal_cmd);
+    
+    for (int t = 0; t < 10; t++) {
+        patika_tick(ctx);
+    }
+    
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(1, snap->agent_count);
+    TEST_ASSERT_EQUAL(3, snap->agents[0].pos_q);
+    TEST_ASSERT_EQUAL(0, snap->agents[0].pos_r);
+    TEST_ASSERT_EQUAL(STATE_IDLE, snap->agents[0].state);
+    
+    PatikaEvent events[10];
+    uint32_t count = patika_poll_events(ctx, events, 10);
+    TEST_ASSERT_EQUAL(1, count);
+    TEST_ASSERT_EQUAL(EVENT_REACHED_GOAL, events[0].type);
+    TEST_ASSERT_EQUAL(agent_id, events[0].agent_id);
+}
+
+void test_max_agents_ceiling(void) {
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = PATIKA_MAX_AGENTS + 1u,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 256,
+        .rng_seed = 12345
+    };
+    TEST_ASSERT_NULL(patika_create(&config));
+    
+    config.max_agents = 0;
+    TEST_ASSERT_NULL(patika_create(&config));
+}
+
+static PatikaCommand spawn_command(int32_t q, int32_t r, AgentID *out_id) {
+    AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+    payload->start_q = q;
+    payload->start_r = r;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    payload->out_agent_id = out_id;
+    
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENT;
+    cmd.large_command.payload = payload;
+    return cmd;
+}
+
+void test_scheduled_commands(void) {
+    AgentID soon = PATIKA_INVALID_AGENT_ID;
+    AgentID later = PATIKA_INVALID_AGENT_ID;
+    AgentID much_later = PATIKA_INVALID_AGENT_ID;
+    
+    PatikaCommand cmd = spawn_command(0, 0, &soon);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &cmd, 3));
+    cmd = spawn_command(1, 0, &later);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &cmd, 300));
+    cmd = spawn_command(2, 0, &much_later);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &cmd, 70000));
+    
+    // two goals due on the same tick fire in scheduling order
+    PatikaCommand goal = {0};
+    goal.type = CMD_SET_GOAL;
+    goal.set_goal.goal_q = 4;
+    goal.set_goal.goal_r = 4;
+    
+    patika_tick(ctx); // tick 0
+    TEST_ASSERT_EQUAL(3, patika_get_stats(ctx).scheduled_commands);
+    
+    patika_tick(ctx); // tick 1
+    patika_tick(ctx); // tick 2
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_AGENT_ID, soon);
+    patika_tick(ctx); // tick 3
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, soon);
+    TEST_ASSERT_EQUAL(1, patika_get_snapshot(ctx)->agent_count);
+    
+    goal.set_goal.agent_id = soon;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &goal, 10));
+    goal.set_goal.goal_q = 5;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &goal, 10));
+    
+    while (patika_get_stats(ctx).total_ticks < 10)
+        patika_tick(ctx);
+    patika_tick(ctx); // tick 10
+    TEST_ASSERT_EQUAL(5, patika_get_snapshot(ctx)->agents[0].target_q);
+    
+    while (patika_get_stats(ctx).total_ticks < 300)
+        patika_tick(ctx);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_AGENT_ID, later);
+    patika_tick(ctx); // tick 300
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, later);
+    
+    while (patika_get_stats(ctx).total_ticks < 70000)
+        patika_tick(ctx);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_AGENT_ID, much_later);
+    patika_tick(ctx); // tick 70000
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, much_later);
+    TEST_ASSERT_EQUAL(0, patika_get_stats(ctx).scheduled_commands);
+    
+    // a tick in the past runs right after the batch that dequeued it,
+    // so it lands after a goal submitted behind it
+    goal.set_goal.goal_q = 7;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &goal, 5));
+    goal.set_goal.goal_q = 6;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &goal));
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(0, patika_get_stats(ctx).scheduled_commands);
+    TEST_ASSERT_EQUAL(7, patika_get_snapshot(ctx)->agents[0].target_q);
+}
+
+void test_destroy_releases_scheduled_commands(void) {
+    PatikaCommand cmd = spawn_command(0, 0, NULL);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &cmd, 1000));
+    cmd = spawn_command(1, 0, NULL);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &cmd, 1ull << 40));
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(2, patika_get_stats(ctx).scheduled_commands);
+}
+
+static void queue_tile_commands(uint32_t count) {
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_SET_TILE_STATE;
+    for (uint32_t i = 0; i < count; i++) {
+        cmd.set_tile.q = (int32_t)(i % 10);
+        cmd.set_tile.r = (int32_t)(i % 7);
+        cmd.set_tile.state = 0;
+        TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    }
+}
+
+void test_command_budget(void) {
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 1024,
+        .event_queue_size = 256,
+        .rng_seed = 12345,
+        .max_commands_per_tick = 40
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    queue_tile_commands(100);
+    patika_tick(ctx);
+    PatikaStats stats = patika_get_stats(ctx);
+    TEST_ASSERT_EQUAL_UINT64(40, stats.commands_processed);
+    TEST_ASSERT_EQUAL(60, stats.command_backlog);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.command_backlog_ticks);
+    TEST_ASSERT_EQUAL(100, stats.command_queue_high_watermark);
+    
+    patika_tick(ctx);
+    stats = patika_get_stats(ctx);
+    TEST_ASSERT_EQUAL(20, stats.command_backlog);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.command_backlog_ticks);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.command_budget_hits);
+    
+    patika_tick(ctx);
+    stats = patika_get_stats(ctx);
+    TEST_ASSERT_EQUAL_UINT64(100, stats.commands_processed);
+    TEST_ASSERT_EQUAL(0, stats.command_backlog);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.command_backlog_ticks);
+    
+    // a time budget too small for anything stops after the first chunk
+    patika_destroy(ctx);
+    config.max_commands_per_tick = 0;
+    config.command_budget_us = 1;
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    queue_tile_commands(1000);
+    patika_tick(ctx);
+    stats = patika_get_stats(ctx);
+    TEST_ASSERT_TRUE(stats.commands_processed > 0);
+    TEST_ASSERT_TRUE(stats.commands_processed < 1000);
+    TEST_ASSERT_EQUAL(1000 - stats.commands_processed, stats.command_backlog);
+    
+    for (int i = 0; i < 10 && stats.command_backlog > 0; i++) {
+        patika_tick(ctx);
+        stats = patika_get_stats(ctx);
+    }
+    TEST_ASSERT_EQUAL_UINT64(1000, stats.commands_processed);
+    TEST_ASSERT_EQUAL(0, stats.command_backlog);
+}
+
 int main(void) {
     UNITY_BEGIN();
     
@@ -209,6 +422,11 @@ int main(void) {
     RUN_TEST(test_poll_events);
     RUN_TEST(test_get_stats);
     RUN_TEST(test_snapshot_version_increments);
+    RUN_TEST(test_agent_reaches_goal);
+    RUN_TEST(test_max_agents_ceiling);
+    RUN_TEST(test_scheduled_commands);
+    RUN_TEST(test_destroy_releases_scheduled_commands);
+    RUN_TEST(test_command_budget);
     
     return UNITY_END();
 }
\ No newline at end of file
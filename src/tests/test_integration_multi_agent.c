@@ -1,5 +1,6 @@
 #include "unity.h"
 #include "patika.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -138,7 +139,7 @@ void test_rapid_spawn_destroy(void) {
 void test_agent_movement_simulation(void) {
     for (int i = 0; i < 5; i++) {
         AddAgentPayload *payload = malloc(sizeof(AddAgentPayload));
-        payload->start_q = 0;
+        payload->start_q = i; // an occupied tile refuses the spawn
         payload->start_r = 0;
         payload->faction = 0;
         payload->side = 0;
@@ -308,6 +309,964 @@ void test_rectangular_map(void) {
     patika_tick(ctx);
 }
 
+void test_snapshot_skips_removed_agents(void) {
+    AgentID ids[10];
+    for (int i = 0; i < 10; i++) {
+        AddAgentPayload *payload = malloc(sizeof(AddAgentPayload));
+        payload->start_q = i;
+        payload->start_r = 0;
+        payload->faction = 0;
+        payload->side = 0;
+        payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+        payload->out_agent_id = &ids[i];
+        payload->collision_data.layer = 0;
+        payload->collision_data.collision_mask = 0;
+        payload->collision_data.aggression_mask = 0;
+        
+        PatikaCommand cmd = {0};
+        cmd.type = CMD_ADD_AGENT;
+        cmd.large_command.payload = payload;
+        patika_submit_command(ctx, &cmd);
+    }
+    
+    patika_tick(ctx);
+    
+    for (int i = 2; i < 5; i++) {
+        PatikaCommand cmd = {0};
+        cmd.type = CMD_REMOVE_AGENT;
+        cmd.remove_agent.agent_id = ids[i];
+        patika_submit_command(ctx, &cmd);
+    }
+    
+    patika_tick(ctx);
+    
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(7, snap->agent_count);
+    
+    for (uint32_t i = 0; i < snap->agent_count; i++) {
+        for (int j = 2; j < 5; j++) {
+            TEST_ASSERT_NOT_EQUAL(ids[j], snap->agents[i].id);
+        }
+    }
+}
+
+void test_bulk_spawn_wave(void) {
+    PatikaSpawnRecord records[20];
+    AgentID ids[20];
+    PatikaError results[20];
+    
+    memset(records, 0, sizeof(records));
+    for (int i = 0; i < 20; i++) {
+        records[i].start_q = (i % 10) - 5;
+        records[i].start_r = (i / 10) - 5;
+        records[i].parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    }
+    records[3].start_q = 1000;   // out of bounds
+    records[7].start_q = 2;      // blocked below
+    records[7].start_r = 2;
+    records[12].start_q = records[11].start_q; // same tile as 11
+    records[12].start_r = records[11].start_r;
+    
+    PatikaCommand tile_cmd = {0};
+    tile_cmd.type = CMD_SET_TILE_STATE;
+    tile_cmd.set_tile.q = 2;
+    tile_cmd.set_tile.r = 2;
+    tile_cmd.set_tile.state = 1;
+    patika_submit_command(ctx, &tile_cmd);
+    
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENTS_BULK;
+    cmd.add_agents_bulk.records = records;
+    cmd.add_agents_bulk.out_agent_ids = ids;
+    cmd.add_agents_bulk.out_results = results;
+    cmd.add_agents_bulk.count = 20;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    
+    patika_tick(ctx);
+    
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(17, snap->agent_count);
+    TEST_ASSERT_EQUAL(PATIKA_ERR_OUT_OF_BOUNDS, results[3]);
+    TEST_ASSERT_EQUAL(PATIKA_ERR_BUSY, results[7]);
+    TEST_ASSERT_EQUAL(PATIKA_ERR_BUSY, results[12]);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_AGENT_ID, ids[3]);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_AGENT_ID, ids[7]);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_AGENT_ID, ids[12]);
+    
+    for (int i = 0; i < 20; i++) {
+        if (i == 3 || i == 7 || i == 12) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL(PATIKA_OK, results[i]);
+        TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, ids[i]);
+    }
+    
+    PatikaStats stats = patika_get_stats(ctx);
+    TEST_ASSERT_EQUAL(17, stats.active_agents);
+}
+
+static AgentID spawn_at(int q, int r) {
+    AgentID id = PATIKA_INVALID_AGENT_ID;
+    AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+    payload->start_q = q;
+    payload->start_r = r;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    payload->out_agent_id = &id;
+    
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENT;
+    cmd.large_command.payload = payload;
+    patika_submit_command(ctx, &cmd);
+    patika_tick(ctx);
+    return id;
+}
+
+static void goal_cmd(PatikaCommand *cmd, AgentID id, int32_t q, int32_t r) {
+    cmd->type = CMD_SET_GOAL;
+    cmd->set_goal.agent_id = id;
+    cmd->set_goal.goal_q = q;
+    cmd->set_goal.goal_r = r;
+}
+
+void test_command_coalescing(void) {
+    patika_destroy(ctx);
+    
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 10,
+        .grid_height = 10,
+        .command_queue_size = 256,
+        .event_queue_size = 256,
+        .rng_seed = 2468,
+        .coalesce_commands = 1
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    AgentID a = spawn_at(0, 0);
+    AgentID b = spawn_at(1, 0);
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, a);
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, b);
+    
+    PatikaCommand cmds[12];
+    memset(cmds, 0, sizeof(cmds));
+    // drag-to-move: only the last in-bounds goal survives
+    goal_cmd(&cmds[0], a, 2, 2);
+    goal_cmd(&cmds[1], a, 3, 3);
+    goal_cmd(&cmds[2], a, 100, 100);
+    // tile toggled twice
+    cmds[3].type = CMD_SET_TILE_STATE;
+    cmds[3].set_tile.q = 5;
+    cmds[3].set_tile.state = 1;
+    cmds[4].type = CMD_SET_TILE_STATE;
+    cmds[4].set_tile.q = 5;
+    cmds[4].set_tile.state = 0;
+    // goal for an agent removed in the same batch, removed twice
+    goal_cmd(&cmds[5], b, 4, 4);
+    cmds[6].type = CMD_REMOVE_AGENT;
+    cmds[6].remove_agent.agent_id = b;
+    cmds[7].type = CMD_REMOVE_AGENT;
+    cmds[7].remove_agent.agent_id = b;
+    // a spawn in between keeps both tile edits
+    cmds[8].type = CMD_SET_TILE_STATE;
+    cmds[8].set_tile.q = -3;
+    cmds[8].set_tile.state = 1;
+    AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+    payload->start_q = -3;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    cmds[9].type = CMD_ADD_AGENT;
+    cmds[9].large_command.payload = payload;
+    cmds[10].type = CMD_SET_TILE_STATE;
+    cmds[10].set_tile.q = -3;
+    cmds[10].set_tile.state = 0;
+    goal_cmd(&cmds[11], b, 1, 1);
+    
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_commands(ctx, cmds, 12));
+    patika_tick(ctx);
+    
+    PatikaStats stats = patika_get_stats(ctx);
+    TEST_ASSERT_EQUAL(5, stats.commands_coalesced);
+    
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(1, snap->agent_count); // spawn on the blocked tile failed
+    TEST_ASSERT_EQUAL(a, snap->agents[0].id);
+    TEST_ASSERT_EQUAL(3, snap->agents[0].target_q);
+    TEST_ASSERT_EQUAL(3, snap->agents[0].target_r);
+}
+
+void test_sorted_command_dispatch(void) {
+    patika_destroy(ctx);
+    
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 2,
+        .max_barracks = 10,
+        .grid_width = 10,
+        .grid_height = 10,
+        .command_queue_size = 256,
+        .event_queue_size = 256,
+        .rng_seed = 1357,
+        .sort_commands = 1
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    AgentID a = spawn_at(0, 0);
+    AgentID b = spawn_at(1, 0);
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, b);
+    
+    AgentID spawned = PATIKA_INVALID_AGENT_ID;
+    AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+    payload->start_q = 4;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    payload->out_agent_id = &spawned;
+    
+    PatikaCommand cmds[6];
+    memset(cmds, 0, sizeof(cmds));
+    goal_cmd(&cmds[0], b, 2, 2);
+    goal_cmd(&cmds[1], b, 3, 3);
+    // pool is full: the spawn only fits because the remove below runs first
+    cmds[2].type = CMD_ADD_AGENT;
+    cmds[2].large_command.payload = payload;
+    cmds[3].type = CMD_REMOVE_AGENT;
+    cmds[3].remove_agent.agent_id = a;
+    // blocked then cleared: the spawn sees the final map
+    cmds[4].type = CMD_SET_TILE_STATE;
+    cmds[4].set_tile.q = 4;
+    cmds[4].set_tile.state = 1;
+    cmds[5].type = CMD_SET_TILE_STATE;
+    cmds[5].set_tile.q = 4;
+    cmds[5].set_tile.state = 0;
+    
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_commands(ctx, cmds, 6));
+    patika_tick(ctx);
+    
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, spawned);
+    TEST_ASSERT_EQUAL(2 + 6, patika_get_stats(ctx).commands_processed);
+    
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(2, snap->agent_count);
+    for (uint32_t i = 0; i < snap->agent_count; i++) {
+        TEST_ASSERT_NOT_EQUAL(a, snap->agents[i].id);
+        if (snap->agents[i].id == b) {
+            // goals for one agent keep their order
+            TEST_ASSERT_EQUAL(3, snap->agents[i].target_q);
+            TEST_ASSERT_EQUAL(3, snap->agents[i].target_r);
+        }
+    }
+}
+
+void test_command_stream_roundtrip(void) {
+    uint8_t buf[512];
+    size_t len = patika_stream_write_header(buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(PATIKA_STREAM_HEADER_SIZE, len);
+    
+    AddAgentPayload agent = {0};
+    agent.start_q = 2;
+    agent.start_r = -1;
+    agent.faction = 3;
+    agent.parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    agent.collision_data.layer = 1;
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENT;
+    cmd.large_command.payload = &agent;
+    len += patika_stream_encode(&cmd, buf + len, sizeof(buf) - len);
+    
+    PatikaSpawnRecord wave[3];
+    memset(wave, 0, sizeof(wave));
+    for (int i = 0; i < 3; i++) {
+        wave[i].start_q = -4 + i;
+        wave[i].start_r = 3;
+        wave[i].side = 1;
+        wave[i].parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    }
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_ADD_AGENTS_BULK;
+    cmd.add_agents_bulk.records = wave;
+    cmd.add_agents_bulk.count = 3;
+    len += patika_stream_encode(&cmd, buf + len, sizeof(buf) - len);
+    
+    AddBarrackPayload barrack = {0};
+    barrack.pos_q = 5;
+    barrack.pos_r = 5;
+    barrack.max_agents = 10;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_ADD_BARRACK;
+    cmd.large_command.payload = &barrack;
+    len += patika_stream_encode(&cmd, buf + len, sizeof(buf) - len);
+    
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_TILE_STATE;
+    cmd.set_tile.q = 7;
+    cmd.set_tile.r = -7;
+    cmd.set_tile.state = 1;
+    size_t tile_len = patika_stream_encode(&cmd, buf + len, sizeof(buf) - len);
+    TEST_ASSERT_EQUAL(PATIKA_STREAM_RECORD_HEADER_SIZE + 12, tile_len);
+    len += tile_len;
+    
+    // no encoding for debug commands, and nothing is written
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_DEBUG_DUMP_STATE;
+    TEST_ASSERT_EQUAL(0, patika_stream_encode(&cmd, buf + len, sizeof(buf) - len));
+    
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_stream(ctx, buf, len));
+    patika_tick(ctx);
+    
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(4, snap->agent_count);
+    TEST_ASSERT_EQUAL(1, patika_get_stats(ctx).active_barracks);
+    TEST_ASSERT_EQUAL(2, snap->agents[0].pos_q);
+    TEST_ASSERT_EQUAL(-1, snap->agents[0].pos_r);
+    TEST_ASSERT_EQUAL(3, snap->agents[0].faction);
+    
+    // goal for a live agent, encoded against its real ID
+    AgentID id = snap->agents[0].id;
+    len = patika_stream_write_header(buf, sizeof(buf));
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_GOAL;
+    cmd.set_goal.agent_id = id;
+    cmd.set_goal.goal_q = 0;
+    cmd.set_goal.goal_r = 4;
+    len += patika_stream_encode(&cmd, buf + len, sizeof(buf) - len);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_stream(ctx, buf, len));
+    patika_tick(ctx);
+    snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(0, snap->agents[0].target_q);
+    TEST_ASSERT_EQUAL(4, snap->agents[0].target_r);
+    
+    // malformed streams are rejected whole
+    uint64_t processed = patika_get_stats(ctx).commands_processed;
+    TEST_ASSERT_EQUAL(PATIKA_ERR_BAD_STREAM, patika_submit_stream(ctx, buf, len - 1));
+    buf[0] ^= 0xFF;
+    TEST_ASSERT_EQUAL(PATIKA_ERR_BAD_STREAM, patika_submit_stream(ctx, buf, len));
+    buf[0] ^= 0xFF;
+    buf[PATIKA_STREAM_HEADER_SIZE] = CMD_DEBUG_DUMP_STATE;
+    TEST_ASSERT_EQUAL(PATIKA_ERR_INVALID_COMMAND_TYPE, patika_submit_stream(ctx, buf, len));
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(processed, patika_get_stats(ctx).commands_processed);
+}
+
+void test_journal_replay(void) {
+    const char *path = "patika_test_journal.bin";
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 256,
+        .rng_seed = 4242,
+        .sort_commands = 1,
+        .journal_path = path
+    };
+    patika_destroy(ctx);
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    AgentID ids[6];
+    for (int i = 0; i < 6; i++) {
+        ids[i] = spawn_at(i, 1);
+        TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_AGENT_ID, ids[i]);
+    }
+    
+    // a scheduled spawn fires ahead of the sorted batch that blocks its tile;
+    // re-sorting on replay would run the tile edit first and lose the agent
+    AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+    payload->start_q = 12;
+    payload->start_r = 2;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENT;
+    cmd.large_command.payload = payload;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &cmd, patika_get_stats(ctx).total_ticks + 1));
+    patika_tick(ctx);
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_SET_TILE_STATE;
+    cmd.set_tile.q = 12;
+    cmd.set_tile.r = 2;
+    cmd.set_tile.state = 1;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(7, patika_get_stats(ctx).active_agents);
+    
+    for (int i = 0; i < 5; i++) {
+        goal_cmd(&cmd, ids[i], 6 - i, 5);
+        TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    }
+    goal_cmd(&cmd, ids[5], -6, -4);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_schedule_command(ctx, &cmd, patika_get_stats(ctx).total_ticks + 4));
+    for (int i = 0; i < 12; i++) {
+        patika_tick(ctx);
+    }
+    
+    PatikaStats recorded = patika_get_stats(ctx);
+    PatikaSnapshot expected = *patika_get_snapshot(ctx);
+    AgentSnapshot agents[7];
+    TEST_ASSERT_EQUAL(7, expected.agent_count);
+    memcpy(agents, expected.agents, sizeof(agents));
+    patika_destroy(ctx);
+    
+    config.journal_path = NULL;
+    ctx = patika_create(&config);
+    uint64_t ticks = 0;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_replay(ctx, path, &ticks));
+    TEST_ASSERT_EQUAL_UINT64(recorded.total_ticks, ticks);
+    
+    PatikaStats replayed = patika_get_stats(ctx);
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL_UINT64(recorded.total_ticks, replayed.total_ticks);
+    TEST_ASSERT_EQUAL_UINT64(recorded.commands_processed, replayed.commands_processed);
+    TEST_ASSERT_EQUAL(expected.agent_count, snap->agent_count);
+    for (uint32_t i = 0; i < snap->agent_count; i++) {
+        TEST_ASSERT_EQUAL(agents[i].id, snap->agents[i].id);
+        TEST_ASSERT_EQUAL(agents[i].pos_q, snap->agents[i].pos_q);
+        TEST_ASSERT_EQUAL(agents[i].pos_r, snap->agents[i].pos_r);
+        TEST_ASSERT_EQUAL(agents[i].target_q, snap->agents[i].target_q);
+        TEST_ASSERT_EQUAL(agents[i].target_r, snap->agents[i].target_r);
+    }
+    
+    TEST_ASSERT_EQUAL(PATIKA_ERR_IO, patika_replay(ctx, "patika_missing_journal.bin", NULL));
+    remove(path);
+    
+    config.journal_path = "patika_missing_dir/journal.bin";
+    TEST_ASSERT_NULL(patika_create(&config));
+}
+
+static void spawn_and_remove(uint32_t count) {
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_REMOVE_AGENT;
+    for (uint32_t i = 0; i < count; i++) {
+        cmd.remove_agent.agent_id = spawn_at((int)i, 2);
+        TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    }
+    patika_tick(ctx);
+}
+
+void test_bulk_event_polling(void) {
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 8,
+        .rng_seed = 99
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    PatikaEvent events[8];
+    spawn_and_remove(5);
+    TEST_ASSERT_EQUAL(3, patika_poll_events(ctx, events, 3));
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(EVENT_AGENT_REMOVED, events[i].type);
+    }
+    
+    // 2 left plus 4 new wraps the 8-slot ring
+    spawn_and_remove(4);
+    PatikaEventSpan span;
+    TEST_ASSERT_EQUAL(6, patika_peek_events(ctx, 8, &span));
+    TEST_ASSERT_EQUAL(5, span.first_count);
+    TEST_ASSERT_EQUAL(1, span.second_count);
+    TEST_ASSERT_EQUAL(EVENT_AGENT_REMOVED, span.second[0].type);
+    
+    // peeking does not consume, committing part of a peek does
+    TEST_ASSERT_EQUAL(2, patika_peek_events(ctx, 2, &span));
+    TEST_ASSERT_EQUAL(0, span.second_count);
+    AgentID oldest = span.first[0].agent_id;
+    TEST_ASSERT_EQUAL(2, patika_poll_events(ctx, events, 2));
+    TEST_ASSERT_EQUAL(oldest, events[0].agent_id);
+    
+    TEST_ASSERT_EQUAL(4, patika_peek_events(ctx, 8, &span));
+    // committing more than is readable is clamped, the tail never passes head
+    patika_commit_events(ctx, 6);
+    TEST_ASSERT_EQUAL(0, patika_peek_events(ctx, 8, &span));
+    TEST_ASSERT_EQUAL(0, patika_poll_events(ctx, events, 8));
+    TEST_ASSERT_EQUAL_UINT64(9, patika_get_stats(ctx).events_emitted);
+}
+
+void test_broadcast_subscribers(void) {
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 0,
+        .rng_seed = 99,
+        .max_event_subscribers = 2,
+        .event_broadcast_size = 8,
+        .event_overflow_policy = PATIKA_OVERFLOW_DROP_OLDEST
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    PatikaEventCursor net = patika_subscribe_events(ctx);
+    PatikaEventCursor ai = patika_subscribe_events(ctx);
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_EVENT_CURSOR, net);
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_EVENT_CURSOR, ai);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_EVENT_CURSOR, patika_subscribe_events(ctx));
+    
+    // both cursors see the same events, each at its own pace
+    spawn_and_remove(4);
+    PatikaEventSpan a, b;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_peek_events(ctx, net, 16, &a));
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_peek_events(ctx, ai, 1, &b));
+    TEST_ASSERT_EQUAL(4, a.first_count + a.second_count);
+    TEST_ASSERT_EQUAL(1, b.first_count + b.second_count);
+    TEST_ASSERT_EQUAL_PTR(a.first, b.first);
+    TEST_ASSERT_EQUAL(EVENT_AGENT_REMOVED, a.first[0].type);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_commit_events(ctx, net, 4));
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_commit_events(ctx, ai, 1));
+    
+    // ai is 3 behind; 10 more events lap it, net keeps up
+    spawn_and_remove(5);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_peek_events(ctx, net, 16, &a));
+    TEST_ASSERT_EQUAL(5, a.first_count + a.second_count);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_commit_events(ctx, net, 5));
+    spawn_and_remove(5);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_peek_events(ctx, ai, 16, &b));
+    TEST_ASSERT_EQUAL(7, b.first_count + b.second_count);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_commit_events(ctx, ai, 7));
+    
+    PatikaCursorStats stats;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_cursor_stats(ctx, ai, &stats));
+    TEST_ASSERT_EQUAL_UINT64(8, stats.delivered);
+    TEST_ASSERT_EQUAL_UINT64(6, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.pending);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_cursor_stats(ctx, net, &stats));
+    TEST_ASSERT_EQUAL_UINT64(9, stats.delivered);
+    TEST_ASSERT_EQUAL_UINT64(5, stats.pending);
+    
+    // a freed cursor can be handed out again
+    patika_unsubscribe_events(ctx, ai);
+    TEST_ASSERT_EQUAL(PATIKA_ERR_INVALID_ID, patika_cursor_peek_events(ctx, ai, 16, &b));
+    TEST_ASSERT_EQUAL(ai, patika_subscribe_events(ctx));
+    
+    // lag detection reports the overrun once, then resumes at the oldest event
+    patika_destroy(ctx);
+    config.event_overflow_policy = PATIKA_OVERFLOW_LAG;
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    net = patika_subscribe_events(ctx);
+    spawn_and_remove(10);
+    TEST_ASSERT_EQUAL(PATIKA_ERR_LAGGED, patika_cursor_peek_events(ctx, net, 16, &a));
+    TEST_ASSERT_EQUAL(0, a.first_count + a.second_count);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_peek_events(ctx, net, 16, &a));
+    TEST_ASSERT_EQUAL(7, a.first_count + a.second_count);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_commit_events(ctx, net, 7));
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_cursor_stats(ctx, net, &stats));
+    TEST_ASSERT_EQUAL_UINT64(3, stats.dropped);
+}
+
+static void spawn_and_remove_faction(int q, uint8_t side, uint8_t faction) {
+    AgentID id = PATIKA_INVALID_AGENT_ID;
+    AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+    payload->start_q = q;
+    payload->start_r = 3;
+    payload->side = side;
+    payload->faction = faction;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    payload->out_agent_id = &id;
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENT;
+    cmd.large_command.payload = payload;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_REMOVE_AGENT;
+    cmd.remove_agent.agent_id = id;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+}
+
+void test_event_filters(void) {
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 4,
+        .rng_seed = 99,
+        .max_event_subscribers = 1,
+        .event_broadcast_size = 8
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    // the queue only wants removals from faction 2; a burst from other
+    // factions no longer fills it
+    PatikaEventFilter queue_filter = {
+        PATIKA_EVENT_BIT(EVENT_AGENT_REMOVED), 0xFFFFFFFFu, PATIKA_EVENT_BIT(2)
+    };
+    patika_set_event_filter(ctx, &queue_filter);
+    
+    // the subscriber only wants side 1, any faction
+    PatikaEventCursor cursor = patika_subscribe_events(ctx);
+    PatikaEventFilter side_filter = {0xFFFFFFFFu, PATIKA_EVENT_BIT(1), 0xFFFFFFFFu};
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_set_cursor_filter(ctx, cursor, &side_filter));
+    
+    for (int i = 0; i < 6; i++) {
+        spawn_and_remove_faction(i, 0, 0);
+    }
+    spawn_and_remove_faction(6, 0, 2);
+    spawn_and_remove_faction(7, 1, 2);
+    spawn_and_remove_faction(8, 1, 40);
+    
+    PatikaEvent events[4];
+    TEST_ASSERT_EQUAL(2, patika_poll_events(ctx, events, 4));
+    TEST_ASSERT_EQUAL(EVENT_AGENT_REMOVED, events[0].type);
+    
+    PatikaEventSpan span;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_cursor_peek_events(ctx, cursor, 8, &span));
+    TEST_ASSERT_EQUAL(2, span.first_count + span.second_count);
+    TEST_ASSERT_EQUAL_UINT64(6, patika_get_stats(ctx).events_filtered);
+    
+    // nobody wants anything: nothing is pushed at all
+    PatikaEventFilter none = {0, 0, 0};
+    patika_set_event_filter(ctx, &none);
+    patika_unsubscribe_events(ctx, cursor);
+    spawn_and_remove_faction(9, 1, 2);
+    TEST_ASSERT_EQUAL(0, patika_poll_events(ctx, events, 4));
+    TEST_ASSERT_EQUAL_UINT64(7, patika_get_stats(ctx).events_filtered);
+    
+    patika_set_event_filter(ctx, NULL);
+    spawn_and_remove_faction(10, 0, 0);
+    TEST_ASSERT_EQUAL(1, patika_poll_events(ctx, events, 4));
+}
+
+void test_event_overflow_and_coalescing(void) {
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 4,
+        .rng_seed = 99,
+        .coalesce_events = 1
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    // 3 usable slots, 6 removals: 3 are lost and owed as one overflow record
+    spawn_and_remove(6);
+    PatikaStats stats = patika_get_stats(ctx);
+    TEST_ASSERT_EQUAL_UINT64(3, stats.events_dropped[EVENT_AGENT_REMOVED]);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.events_dropped[EVENT_REACHED_GOAL]);
+    
+    PatikaEvent events[4];
+    TEST_ASSERT_EQUAL(3, patika_poll_events(ctx, events, 4));
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(1, patika_poll_events(ctx, events, 4));
+    TEST_ASSERT_EQUAL(EVENT_OVERFLOW, events[0].type);
+    TEST_ASSERT_EQUAL(3, events[0].pos_q);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_AGENT_ID, events[0].agent_id);
+    
+    // repeated arrivals of one agent stay a single queued event until read
+    AgentID id = spawn_at(4, 4);
+    PatikaCommand cmd = {0};
+    for (int i = 0; i < 3; i++) {
+        goal_cmd(&cmd, id, 4, 4);
+        TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+        patika_tick(ctx);
+        patika_tick(ctx);
+    }
+    TEST_ASSERT_EQUAL(1, patika_poll_events(ctx, events, 4));
+    TEST_ASSERT_EQUAL(EVENT_REACHED_GOAL, events[0].type);
+    TEST_ASSERT_EQUAL(id, events[0].agent_id);
+    TEST_ASSERT_EQUAL_UINT64(2, patika_get_stats(ctx).events_coalesced);
+    
+    // once read, the next arrival is queued again, also through peek/commit
+    goal_cmd(&cmd, id, 4, 4);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    patika_tick(ctx);
+    PatikaEventSpan span;
+    TEST_ASSERT_EQUAL(1, patika_peek_events(ctx, 4, &span));
+    patika_commit_events(ctx, 1);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(1, patika_poll_events(ctx, events, 4));
+    TEST_ASSERT_EQUAL_UINT64(2, patika_get_stats(ctx).events_coalesced);
+}
+
+void test_movement_deltas(void) {
+    TEST_ASSERT_NULL(patika_get_movement_deltas(ctx));
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 256,
+        .rng_seed = 99,
+        .movement_deltas = 1
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    AgentID walker = spawn_at(0, 0);
+    spawn_at(5, 5); // stays put
+    PatikaCommand cmd = {0};
+    goal_cmd(&cmd, walker, 4, 0);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    
+    uint32_t moves = 0;
+    for (int t = 0; t < 10; t++) {
+        patika_tick(ctx);
+        const PatikaMovementDeltas *d = patika_get_movement_deltas(ctx);
+        TEST_ASSERT_NOT_NULL(d);
+        TEST_ASSERT_EQUAL_UINT64(patika_get_stats(ctx).total_ticks - 1, d->tick);
+        TEST_ASSERT_TRUE(d->count <= 1);
+        if (d->count == 1) {
+            const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+            TEST_ASSERT_EQUAL((uint32_t)(walker & 0xFFFFu), d->deltas[0].agent_index & 0xFFFFu);
+            TEST_ASSERT_EQUAL(snap->agents[0].pos_q, d->deltas[0].q);
+            TEST_ASSERT_EQUAL(snap->agents[0].pos_r, d->deltas[0].r);
+            moves++;
+        }
+    }
+    TEST_ASSERT_EQUAL(4, moves);
+    
+    // nothing moved in the last tick
+    TEST_ASSERT_EQUAL(0, patika_get_movement_deltas(ctx)->count);
+}
+
+void test_typed_event_records(void) {
+    uint64_t block[64];
+    TEST_ASSERT_EQUAL(0, patika_poll_event_records(ctx, block, sizeof(block)));
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 256,
+        .rng_seed = 99,
+        .event_record_ring_size = 256
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    // records carry what PatikaEvent has no room for
+    spawn_and_remove_faction(1, 1, 7);
+    uint32_t bytes = patika_poll_event_records(ctx, block, sizeof(block));
+    const PatikaEventRecord *rec = (const PatikaEventRecord *)block;
+    TEST_ASSERT_EQUAL(PATIKA_RECORD_SIZE(sizeof(PatikaAgentRecord)), bytes);
+    TEST_ASSERT_EQUAL(bytes, rec->size);
+    TEST_ASSERT_NULL(patika_record_interaction(rec));
+    const PatikaAgentRecord *removed = patika_record_agent_removed(rec);
+    TEST_ASSERT_NOT_NULL(removed);
+    TEST_ASSERT_EQUAL(1, removed->side);
+    TEST_ASSERT_EQUAL(7, removed->faction);
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_BARRACK_ID, removed->barrack_id);
+    TEST_ASSERT_EQUAL(patika_get_stats(ctx).total_ticks - 1, rec->tick);
+    
+    // an arrival and a removal come out in order, walked record by record
+    AgentID id = spawn_at(4, 4);
+    PatikaCommand cmd = {0};
+    goal_cmd(&cmd, id, 5, 4);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    patika_tick(ctx);
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_REMOVE_AGENT;
+    cmd.remove_agent.agent_id = id;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    bytes = patika_poll_event_records(ctx, block, sizeof(block));
+    rec = (const PatikaEventRecord *)block;
+    const PatikaAgentRecord *arrived = patika_record_reached_goal(rec);
+    TEST_ASSERT_NOT_NULL(arrived);
+    TEST_ASSERT_EQUAL(id, arrived->agent_id);
+    TEST_ASSERT_EQUAL(5, arrived->pos_q);
+    TEST_ASSERT_EQUAL(4, arrived->pos_r);
+    rec = patika_record_next(rec);
+    TEST_ASSERT_NOT_NULL(patika_record_agent_removed(rec));
+    TEST_ASSERT_EQUAL_PTR((const uint8_t *)block + bytes, patika_record_next(rec));
+    
+    // a short buffer takes whole records only
+    spawn_and_remove(2);
+    TEST_ASSERT_EQUAL(0, patika_poll_event_records(ctx, block, 8));
+    uint32_t one = PATIKA_RECORD_SIZE(sizeof(PatikaAgentRecord));
+    TEST_ASSERT_EQUAL(one, patika_poll_event_records(ctx, block, one + 8));
+    TEST_ASSERT_EQUAL(one, patika_poll_event_records(ctx, block, sizeof(block)));
+    
+    // a full ring drops records and owes one overflow record; the ring wraps
+    uint32_t fit = 256 / one;
+    spawn_and_remove(fit + 3);
+    TEST_ASSERT_EQUAL_UINT64(3, patika_get_stats(ctx).event_records_dropped);
+    bytes = patika_poll_event_records(ctx, block, sizeof(block));
+    TEST_ASSERT_TRUE(bytes >= (fit - 1) * one);
+    spawn_and_remove(1);
+    bytes = patika_poll_event_records(ctx, block, sizeof(block));
+    rec = (const PatikaEventRecord *)block;
+    const PatikaOverflowRecord *lost = patika_record_overflow(rec);
+    TEST_ASSERT_NOT_NULL(lost);
+    TEST_ASSERT_EQUAL(3, lost->lost);
+    TEST_ASSERT_NOT_NULL(patika_record_agent_removed(patika_record_next(rec)));
+    TEST_ASSERT_EQUAL(PATIKA_RECORD_SIZE(sizeof(PatikaOverflowRecord)) + one, bytes);
+}
+
+void test_snapshot_pinning(void) {
+    AgentID id = spawn_at(2, 2);
+    const PatikaSnapshot *old = patika_acquire_snapshot(ctx);
+    TEST_ASSERT_EQUAL_PTR(patika_get_snapshot(ctx), old);
+    uint64_t old_version = old->version;
+    
+    // the writer works around a pinned snapshot
+    PatikaCommand cmd = {0};
+    goal_cmd(&cmd, id, 6, 2);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    const PatikaSnapshot *latest = patika_acquire_snapshot(ctx);
+    TEST_ASSERT_TRUE(latest != old);
+    patika_tick(ctx);
+    TEST_ASSERT_TRUE(patika_get_snapshot(ctx) != old);
+    TEST_ASSERT_TRUE(patika_get_snapshot(ctx) != latest);
+    TEST_ASSERT_EQUAL_UINT64(0, patika_get_stats(ctx).snapshots_skipped);
+    
+    // both spare buffers pinned: updates are skipped, never overwritten
+    uint64_t published = patika_get_snapshot(ctx)->version;
+    patika_tick(ctx);
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL_UINT64(2, patika_get_stats(ctx).snapshots_skipped);
+    TEST_ASSERT_EQUAL_UINT64(published, patika_get_snapshot(ctx)->version);
+    TEST_ASSERT_EQUAL_UINT64(old_version, old->version);
+    TEST_ASSERT_EQUAL(2, old->agents[0].pos_q);
+    
+    // releasing one lets the next tick write it again
+    patika_release_snapshot(ctx, old);
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL_PTR(old, patika_get_snapshot(ctx));
+    TEST_ASSERT_EQUAL_UINT64(published + 1, old->version);
+    patika_release_snapshot(ctx, latest);
+    TEST_ASSERT_EQUAL_UINT64(2, patika_get_stats(ctx).snapshots_skipped);
+}
+
+void test_snapshot_copies_only_changed_agents(void) {
+    AgentID ids[10];
+    for (int i = 0; i < 10; i++) {
+        ids[i] = spawn_at(i, 3);
+    }
+    // buffers take turns, each catches up on the spawns since its last turn
+    TEST_ASSERT_EQUAL(3, patika_get_stats(ctx).snapshot_entries_copied);
+    
+    // once all three caught up, idle ticks copy nothing
+    patika_tick(ctx);
+    patika_tick(ctx);
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(0, patika_get_stats(ctx).snapshot_entries_copied);
+    
+    PatikaCommand cmd = {0};
+    goal_cmd(&cmd, ids[4], 4, 8);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(1, patika_get_stats(ctx).snapshot_entries_copied);
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(ids[4], snap->agents[4].id);
+    TEST_ASSERT_EQUAL(8, snap->agents[4].target_r);
+    
+    // a removal moves the last agent into the freed entry, in every buffer
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_REMOVE_AGENT;
+    cmd.remove_agent.agent_id = ids[2];
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    for (int t = 0; t < 4; t++) {
+        patika_tick(ctx);
+        snap = patika_get_snapshot(ctx);
+        TEST_ASSERT_EQUAL(9, snap->agent_count);
+        TEST_ASSERT_EQUAL(ids[9], snap->agents[2].id);
+        TEST_ASSERT_EQUAL(9, snap->agents[2].pos_q);
+        for (uint32_t i = 0; i < snap->agent_count; i++) {
+            TEST_ASSERT_NOT_EQUAL(ids[2], snap->agents[i].id);
+        }
+    }
+    
+    // the walker's entry follows it to the goal
+    for (int t = 0; t < 20; t++) {
+        patika_tick(ctx);
+    }
+    snap = patika_get_snapshot(ctx);
+    TEST_ASSERT_EQUAL(ids[4], snap->agents[4].id);
+    TEST_ASSERT_EQUAL(4, snap->agents[4].pos_q);
+    TEST_ASSERT_EQUAL(8, snap->agents[4].pos_r);
+    TEST_ASSERT_EQUAL(STATE_IDLE, snap->agents[4].state);
+    TEST_ASSERT_EQUAL(0, patika_get_stats(ctx).snapshot_entries_copied);
+}
+
+void test_snapshot_soa_columns(void) {
+    TEST_ASSERT_NULL(patika_get_snapshot(ctx)->columns.pos_q);
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_HEXAGONAL,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 20,
+        .grid_height = 20,
+        .command_queue_size = 256,
+        .event_queue_size = 256,
+        .rng_seed = 99,
+        .snapshot_soa = 1
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+    
+    AgentID ids[5];
+    for (int i = 0; i < 5; i++) {
+        ids[i] = spawn_at(i, 6);
+    }
+    PatikaCommand cmd = {0};
+    goal_cmd(&cmd, ids[1], 1, 9);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CMD_REMOVE_AGENT;
+    cmd.remove_agent.agent_id = ids[0];
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    for (int t = 0; t < 12; t++) {
+        patika_tick(ctx);
+    }
+    
+    const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+    const PatikaAgentColumns *c = &snap->columns;
+    TEST_ASSERT_NULL(snap->agents);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)c->id % 64);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)c->pos_q % 64);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)c->pos_r % 64);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)c->state % 64);
+    TEST_ASSERT_EQUAL(0, (uintptr_t)c->faction % 64);
+    
+    // the last agent took the removed one's entry, the walker arrived
+    TEST_ASSERT_EQUAL(4, snap->agent_count);
+    TEST_ASSERT_EQUAL(ids[4], c->id[0]);
+    TEST_ASSERT_EQUAL(4, c->pos_q[0]);
+    TEST_ASSERT_EQUAL(6, c->pos_r[0]);
+    TEST_ASSERT_EQUAL(ids[1], c->id[1]);
+    TEST_ASSERT_EQUAL(1, c->pos_q[1]);
+    TEST_ASSERT_EQUAL(9, c->pos_r[1]);
+    TEST_ASSERT_EQUAL(STATE_IDLE, c->state[1]);
+    TEST_ASSERT_EQUAL(ids[3], c->id[3]);
+}
+
 int main(void) {
     UNITY_BEGIN();
     
@@ -319,6 +1278,21 @@ int main(void) {
     RUN_TEST(test_stats_tracking);
     RUN_TEST(test_snapshot_consistency);
     RUN_TEST(test_rectangular_map);
+    RUN_TEST(test_snapshot_skips_removed_agents);
+    RUN_TEST(test_snapshot_pinning);
+    RUN_TEST(test_snapshot_copies_only_changed_agents);
+    RUN_TEST(test_snapshot_soa_columns);
+    RUN_TEST(test_bulk_spawn_wave);
+    RUN_TEST(test_command_coalescing);
+    RUN_TEST(test_sorted_command_dispatch);
+    RUN_TEST(test_command_stream_roundtrip);
+    RUN_TEST(test_journal_replay);
+    RUN_TEST(test_bulk_event_polling);
+    RUN_TEST(test_broadcast_subscribers);
+    RUN_TEST(test_event_filters);
+    RUN_TEST(test_event_overflow_and_coalescing);
+    RUN_TEST(test_movement_deltas);
+    RUN_TEST(test_typed_event_records);
     
     return UNITY_END();
 }
\ No newline at end of file
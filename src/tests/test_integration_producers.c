@@ -0,0 +1,665 @@
+#include "unity.h"
+#include "patika.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_PRODUCERS 4
+#define SPAWNS_PER_PRODUCER 200
+
+static PatikaHandle ctx = NULL;
+
+void setUp(void) {
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_RECTANGULAR,
+        .max_agents = 2000,
+        .max_barracks = 10,
+        .grid_width = 64,
+        .grid_height = 64,
+        .sector_size = 0,
+        .command_queue_size = 4096,
+        .event_queue_size = 1024,
+        .rng_seed = 4242
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+}
+
+void tearDown(void) {
+    if (ctx) {
+        patika_destroy(ctx);
+        ctx = NULL;
+    }
+}
+
+typedef struct {
+    int producer;
+    int failures;
+} ProducerArgs;
+
+static void *pooled_spawn_producer(void *arg) {
+    ProducerArgs *args = (ProducerArgs *)arg;
+    for (int i = 0; i < SPAWNS_PER_PRODUCER; i++) {
+        AddAgentPayload *payload = patika_alloc_payload(ctx, sizeof(AddAgentPayload));
+        if (!payload) {
+            args->failures++;
+            continue;
+        }
+        memset(payload, 0, sizeof(*payload));
+        payload->start_q = i % 64;
+        payload->start_r = args->producer * 8 + i / 64;
+        payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+
+        PatikaCommand cmd = {0};
+        cmd.type = CMD_ADD_AGENT;
+        cmd.flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+        cmd.large_command.payload = payload;
+        if (patika_submit_command(ctx, &cmd) != PATIKA_OK) {
+            patika_free_payload(ctx, payload);
+            args->failures++;
+        }
+    }
+    return NULL;
+}
+
+void test_pooled_payloads_from_producer_threads(void) {
+    pthread_t threads[NUM_PRODUCERS];
+    ProducerArgs args[NUM_PRODUCERS];
+
+    for (int round = 0; round < 3; round++) {
+        for (int p = 0; p < NUM_PRODUCERS; p++) {
+            args[p].producer = p;
+            args[p].failures = 0;
+            pthread_create(&threads[p], NULL, pooled_spawn_producer, &args[p]);
+        }
+        for (int p = 0; p < NUM_PRODUCERS; p++) {
+            pthread_join(threads[p], NULL);
+            TEST_ASSERT_EQUAL(0, args[p].failures);
+        }
+
+        patika_tick(ctx);
+
+        const PatikaSnapshot *snap = patika_get_snapshot(ctx);
+        TEST_ASSERT_EQUAL(NUM_PRODUCERS * SPAWNS_PER_PRODUCER, snap->agent_count);
+
+        // clear the board so the next round reuses returned blocks
+        for (uint32_t i = 0; i < snap->agent_count; i++) {
+            PatikaCommand cmd = {0};
+            cmd.type = CMD_REMOVE_AGENT;
+            cmd.remove_agent.agent_id = snap->agents[i].id;
+            TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+        }
+        patika_tick(ctx);
+        TEST_ASSERT_EQUAL(0, patika_get_snapshot(ctx)->agent_count);
+    }
+}
+
+void test_oversize_pooled_payload(void) {
+    PatikaSpawnRecord *records = patika_alloc_payload(ctx, 100 * sizeof(PatikaSpawnRecord));
+    TEST_ASSERT_NOT_NULL(records);
+    memset(records, 0, 100 * sizeof(PatikaSpawnRecord));
+    for (int i = 0; i < 100; i++) {
+        records[i].start_q = i % 64;
+        records[i].start_r = 40 + i / 64;
+        records[i].parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    }
+
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENTS_BULK;
+    cmd.flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+    cmd.add_agents_bulk.records = records;
+    cmd.add_agents_bulk.count = 100;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(100, patika_get_snapshot(ctx)->agent_count);
+}
+
+static void *batch_tile_producer(void *arg) {
+    ProducerArgs *args = (ProducerArgs *)arg;
+    PatikaCommand cmds[16];
+    for (int b = 0; b < SPAWNS_PER_PRODUCER / 16; b++) {
+        for (int i = 0; i < 16; i++) {
+            memset(&cmds[i], 0, sizeof(cmds[i]));
+            cmds[i].type = CMD_SET_TILE_STATE;
+            cmds[i].set_tile.q = (b * 16 + i) % 64;
+            cmds[i].set_tile.r = args->producer;
+            cmds[i].set_tile.state = 1;
+        }
+        if (patika_submit_batch(ctx, cmds, 16, PATIKA_SUBMIT_ALL_OR_NOTHING) != 16) {
+            args->failures++;
+        }
+    }
+    return NULL;
+}
+
+void test_submit_batch_modes(void) {
+    PatikaCommand cmds[64];
+    memset(cmds, 0, sizeof(cmds));
+    for (int i = 0; i < 64; i++) {
+        cmds[i].type = CMD_SET_TILE_STATE;
+        cmds[i].set_tile.q = i;
+        cmds[i].set_tile.r = 0;
+    }
+
+    // fill all but 10 slots
+    for (uint32_t i = 0; i < 4096 - 10; i += 64) {
+        uint32_t n = (4096 - 10 - i) < 64 ? (4096 - 10 - i) : 64;
+        TEST_ASSERT_EQUAL(n, patika_submit_batch(ctx, cmds, n, PATIKA_SUBMIT_ALL_OR_NOTHING));
+    }
+
+    TEST_ASSERT_EQUAL(0, patika_submit_batch(ctx, cmds, 11, PATIKA_SUBMIT_ALL_OR_NOTHING));
+    TEST_ASSERT_EQUAL(PATIKA_ERR_QUEUE_FULL, patika_submit_commands(ctx, cmds, 11));
+    TEST_ASSERT_EQUAL(10, patika_submit_batch(ctx, cmds, 64, PATIKA_SUBMIT_PARTIAL));
+    TEST_ASSERT_EQUAL(0, patika_submit_batch(ctx, cmds, 1, PATIKA_SUBMIT_PARTIAL));
+
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(4096, patika_get_stats(ctx).commands_processed);
+
+    TEST_ASSERT_EQUAL(0, patika_submit_batch(ctx, cmds, 0, PATIKA_SUBMIT_PARTIAL));
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_commands(ctx, cmds, 64));
+}
+
+void test_submit_batch_from_producer_threads(void) {
+    pthread_t threads[NUM_PRODUCERS];
+    ProducerArgs args[NUM_PRODUCERS];
+
+    for (int p = 0; p < NUM_PRODUCERS; p++) {
+        args[p].producer = p;
+        args[p].failures = 0;
+        pthread_create(&threads[p], NULL, batch_tile_producer, &args[p]);
+    }
+    for (int p = 0; p < NUM_PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+        TEST_ASSERT_EQUAL(0, args[p].failures);
+    }
+
+    patika_tick(ctx);
+    TEST_ASSERT_EQUAL(NUM_PRODUCERS * (SPAWNS_PER_PRODUCER / 16) * 16,
+                      patika_get_stats(ctx).commands_processed);
+}
+
+typedef struct {
+    PatikaHandle handle;
+    PatikaProducerToken token;
+    AgentID ids[SPAWNS_PER_PRODUCER / 4];
+    int failures;
+} LaneArgs;
+
+static void *lane_spawn_producer(void *arg) {
+    LaneArgs *args = (LaneArgs *)arg;
+    for (int i = 0; i < SPAWNS_PER_PRODUCER / 4; i++) {
+        AddAgentPayload *payload = patika_alloc_payload(args->handle, sizeof(AddAgentPayload));
+        memset(payload, 0, sizeof(*payload));
+        payload->start_q = i;
+        payload->start_r = (int32_t)args->token;
+        payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+        payload->out_agent_id = &args->ids[i];
+
+        PatikaCommand cmd = {0};
+        cmd.type = CMD_ADD_AGENT;
+        cmd.flags = PATIKA_COMMAND_FLAG_POOLED_PAYLOAD;
+        cmd.large_command.payload = payload;
+        if (patika_lane_submit(args->handle, args->token, &cmd) != PATIKA_OK) {
+            patika_free_payload(args->handle, payload);
+            args->failures++;
+        }
+    }
+    return NULL;
+}
+
+void test_producer_lanes_drain_in_lane_order(void) {
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_RECTANGULAR,
+        .max_agents = 1000,
+        .max_barracks = 10,
+        .grid_width = 64,
+        .grid_height = 64,
+        .command_queue_size = 64,
+        .event_queue_size = 64,
+        .rng_seed = 7,
+        .max_producer_lanes = NUM_PRODUCERS,
+        .lane_queue_size = 128
+    };
+    PatikaHandle lanes_ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(lanes_ctx);
+
+    pthread_t threads[NUM_PRODUCERS];
+    LaneArgs args[NUM_PRODUCERS];
+    for (int p = 0; p < NUM_PRODUCERS; p++) {
+        memset(&args[p], 0, sizeof(args[p]));
+        args[p].handle = lanes_ctx;
+        args[p].token = patika_register_producer(lanes_ctx);
+        TEST_ASSERT_EQUAL(p, args[p].token);
+    }
+    TEST_ASSERT_EQUAL(PATIKA_INVALID_PRODUCER_TOKEN, patika_register_producer(lanes_ctx));
+
+    // start the producers in reverse so arrival order differs from lane order
+    for (int p = NUM_PRODUCERS - 1; p >= 0; p--) {
+        pthread_create(&threads[p], NULL, lane_spawn_producer, &args[p]);
+    }
+    for (int p = 0; p < NUM_PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+        TEST_ASSERT_EQUAL(0, args[p].failures);
+    }
+
+    patika_tick(lanes_ctx);
+    TEST_ASSERT_EQUAL(NUM_PRODUCERS * (SPAWNS_PER_PRODUCER / 4), patika_get_snapshot(lanes_ctx)->agent_count);
+
+    // fresh pool hands out slots in processing order: lane by lane, FIFO within
+    AgentID prev = args[0].ids[0];
+    for (int p = 0; p < NUM_PRODUCERS; p++) {
+        for (int i = 0; i < SPAWNS_PER_PRODUCER / 4; i++) {
+            if (p == 0 && i == 0)
+                continue;
+            TEST_ASSERT_TRUE(args[p].ids[i] > prev);
+            prev = args[p].ids[i];
+        }
+    }
+
+    patika_destroy(lanes_ctx);
+}
+
+void test_full_lane_only_rejects_its_producer(void) {
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_RECTANGULAR,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 16,
+        .grid_height = 16,
+        .command_queue_size = 64,
+        .event_queue_size = 64,
+        .rng_seed = 7,
+        .max_producer_lanes = 2,
+        .lane_queue_size = 8
+    };
+    PatikaHandle lanes_ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(lanes_ctx);
+
+    PatikaProducerToken noisy = patika_register_producer(lanes_ctx);
+    PatikaProducerToken quiet = patika_register_producer(lanes_ctx);
+
+    PatikaCommand cmds[10];
+    memset(cmds, 0, sizeof(cmds));
+    for (int i = 0; i < 10; i++) {
+        cmds[i].type = CMD_SET_TILE_STATE;
+        cmds[i].set_tile.q = i;
+    }
+
+    TEST_ASSERT_EQUAL(0, patika_lane_submit_batch(lanes_ctx, noisy, cmds, 10, PATIKA_SUBMIT_ALL_OR_NOTHING));
+    TEST_ASSERT_EQUAL(8, patika_lane_submit_batch(lanes_ctx, noisy, cmds, 10, PATIKA_SUBMIT_PARTIAL));
+    TEST_ASSERT_EQUAL(PATIKA_ERR_QUEUE_FULL, patika_lane_submit(lanes_ctx, noisy, &cmds[0]));
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_lane_submit(lanes_ctx, quiet, &cmds[0]));
+    TEST_ASSERT_EQUAL(PATIKA_ERR_INVALID_ID, patika_lane_submit(lanes_ctx, 5, &cmds[0]));
+
+    PatikaLaneStats stats;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_lane_stats(lanes_ctx, noisy, &stats));
+    TEST_ASSERT_EQUAL(8, stats.submitted);
+    TEST_ASSERT_EQUAL(3, stats.queue_full);
+    TEST_ASSERT_EQUAL(8, stats.pending);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_lane_stats(lanes_ctx, quiet, &stats));
+    TEST_ASSERT_EQUAL(0, stats.queue_full);
+
+    patika_tick(lanes_ctx);
+    TEST_ASSERT_EQUAL(9, patika_get_stats(lanes_ctx).commands_processed);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_lane_stats(lanes_ctx, noisy, &stats));
+    TEST_ASSERT_EQUAL(0, stats.pending);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_lane_submit(lanes_ctx, noisy, &cmds[0]));
+
+    patika_destroy(lanes_ctx);
+}
+
+void test_tick_limit_is_shared_fairly_with_lanes(void) {
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_RECTANGULAR,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 16,
+        .grid_height = 16,
+        .command_queue_size = 256,
+        .event_queue_size = 64,
+        .rng_seed = 7,
+        .max_producer_lanes = 2,
+        .lane_queue_size = 16,
+        .max_commands_per_tick = 20
+    };
+    PatikaHandle lanes_ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(lanes_ctx);
+    PatikaProducerToken small = patika_register_producer(lanes_ctx);
+    PatikaProducerToken large = patika_register_producer(lanes_ctx);
+
+    PatikaCommand cmds[200];
+    memset(cmds, 0, sizeof(cmds));
+    for (int i = 0; i < 200; i++) {
+        cmds[i].type = CMD_SET_TILE_STATE;
+        cmds[i].set_tile.q = i % 16;
+    }
+    // a flood on the shared queue no longer starves the lanes
+    TEST_ASSERT_EQUAL(200, patika_submit_batch(lanes_ctx, cmds, 200, PATIKA_SUBMIT_ALL_OR_NOTHING));
+    TEST_ASSERT_EQUAL(3, patika_lane_submit_batch(lanes_ctx, small, cmds, 3, PATIKA_SUBMIT_ALL_OR_NOTHING));
+    TEST_ASSERT_EQUAL(16, patika_lane_submit_batch(lanes_ctx, large, cmds, 16, PATIKA_SUBMIT_ALL_OR_NOTHING));
+
+    // small needs 3 of its share, the others split the rest
+    patika_tick(lanes_ctx);
+    PatikaLaneStats stats;
+    TEST_ASSERT_EQUAL(20, patika_get_stats(lanes_ctx).commands_processed);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_lane_stats(lanes_ctx, small, &stats));
+    TEST_ASSERT_EQUAL(0, stats.pending);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_lane_stats(lanes_ctx, large, &stats));
+    TEST_ASSERT_TRUE(stats.pending <= 16 - 8);
+
+    patika_tick(lanes_ctx);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_lane_stats(lanes_ctx, large, &stats));
+    TEST_ASSERT_EQUAL(0, stats.pending);
+    TEST_ASSERT_EQUAL(40, patika_get_stats(lanes_ctx).commands_processed);
+
+    patika_destroy(lanes_ctx);
+}
+
+static void *delayed_tick(void *arg) {
+    struct timespec delay = {0, 20 * 1000000L};
+    nanosleep(&delay, NULL);
+    patika_tick((PatikaHandle)arg);
+    return NULL;
+}
+
+void test_submit_wait_parks_until_drained(void) {
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_RECTANGULAR,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 16,
+        .grid_height = 16,
+        .command_queue_size = 8,
+        .event_queue_size = 64,
+        .rng_seed = 7
+    };
+    PatikaHandle small_ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(small_ctx);
+
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_SET_TILE_STATE;
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(small_ctx, &cmd));
+    }
+    TEST_ASSERT_EQUAL(PATIKA_ERR_QUEUE_FULL, patika_submit_command(small_ctx, &cmd));
+
+    // nobody drains: the wait gives up
+    TEST_ASSERT_EQUAL(PATIKA_ERR_TIMEOUT, patika_submit_command_wait(small_ctx, &cmd, 5));
+
+    // the sim thread drains while we are parked
+    pthread_t ticker;
+    pthread_create(&ticker, NULL, delayed_tick, small_ctx);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command_wait(small_ctx, &cmd, 5000));
+    pthread_join(ticker, NULL);
+
+    PatikaStats stats = patika_get_stats(small_ctx);
+    TEST_ASSERT_EQUAL(8, stats.command_queue_high_watermark);
+    TEST_ASSERT_EQUAL(2, stats.submit_waits);
+    TEST_ASSERT_TRUE(stats.submit_wait_ns >= 5 * 1000000ull);
+
+    // room available: no park
+    patika_tick(small_ctx);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command_wait(small_ctx, &cmd, 0));
+    TEST_ASSERT_EQUAL(2, patika_get_stats(small_ctx).submit_waits);
+
+    patika_destroy(small_ctx);
+}
+
+#define BROADCAST_EVENTS 40
+
+typedef struct {
+    PatikaEventCursor cursor;
+    AgentID seen[BROADCAST_EVENTS];
+    uint32_t count;
+} SubscriberArgs;
+
+static void *slow_subscriber(void *arg) {
+    SubscriberArgs *args = (SubscriberArgs *)arg;
+    struct timespec delay = {0, 1000000L};
+    while (args->count < BROADCAST_EVENTS) {
+        PatikaEventSpan span;
+        if (patika_cursor_peek_events(ctx, args->cursor, 3, &span) != PATIKA_OK) {
+            break;
+        }
+        for (uint32_t i = 0; i < span.first_count; i++) {
+            args->seen[args->count++] = span.first[i].agent_id;
+        }
+        for (uint32_t i = 0; i < span.second_count; i++) {
+            args->seen[args->count++] = span.second[i].agent_id;
+        }
+        patika_cursor_commit_events(ctx, args->cursor, span.first_count + span.second_count);
+        nanosleep(&delay, NULL);
+    }
+    return NULL;
+}
+
+void test_blocking_broadcast_waits_for_slowest_subscriber(void) {
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_RECTANGULAR,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 16,
+        .grid_height = 16,
+        .command_queue_size = 64,
+        .event_queue_size = 0,
+        .rng_seed = 7,
+        .max_event_subscribers = 1,
+        .event_broadcast_size = 8,
+        .event_overflow_policy = PATIKA_OVERFLOW_BLOCK
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+
+    AgentID ids[BROADCAST_EVENTS];
+    for (int i = 0; i < BROADCAST_EVENTS; i++) {
+        AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+        payload->start_q = i % 16;
+        payload->start_r = i / 16;
+        payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+        payload->out_agent_id = &ids[i];
+        PatikaCommand cmd = {0};
+        cmd.type = CMD_ADD_AGENT;
+        cmd.large_command.payload = payload;
+        TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    }
+    patika_tick(ctx);
+
+    SubscriberArgs args = {0};
+    args.cursor = patika_subscribe_events(ctx);
+    TEST_ASSERT_NOT_EQUAL(PATIKA_INVALID_EVENT_CURSOR, args.cursor);
+    pthread_t subscriber;
+    pthread_create(&subscriber, NULL, slow_subscriber, &args);
+
+    // one tick emits five rings' worth of events, parking until they are read
+    for (int i = 0; i < BROADCAST_EVENTS; i++) {
+        PatikaCommand cmd = {0};
+        cmd.type = CMD_REMOVE_AGENT;
+        cmd.remove_agent.agent_id = ids[i];
+        TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    }
+    patika_tick(ctx);
+    pthread_join(subscriber, NULL);
+
+    TEST_ASSERT_EQUAL(BROADCAST_EVENTS, args.count);
+    for (int i = 0; i < BROADCAST_EVENTS; i++) {
+        TEST_ASSERT_EQUAL(ids[i], args.seen[i]);
+    }
+    PatikaCursorStats stats;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_get_cursor_stats(ctx, args.cursor, &stats));
+    TEST_ASSERT_EQUAL_UINT64(BROADCAST_EVENTS, stats.delivered);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.dropped);
+}
+
+static AgentID spawn_agent_at(int q, int r) {
+    AgentID id = PATIKA_INVALID_AGENT_ID;
+    AddAgentPayload *payload = calloc(1, sizeof(AddAgentPayload));
+    payload->start_q = q;
+    payload->start_r = r;
+    payload->parent_barrack = PATIKA_INVALID_BARRACK_ID;
+    payload->out_agent_id = &id;
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_ADD_AGENT;
+    cmd.large_command.payload = payload;
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+    patika_tick(ctx);
+    return id;
+}
+
+static void remove_agent_now(AgentID id) {
+    PatikaCommand cmd = {0};
+    cmd.type = CMD_REMOVE_AGENT;
+    cmd.remove_agent.agent_id = id;
+    patika_submit_command(ctx, &cmd);
+    patika_tick(ctx);
+}
+
+static void *delayed_removal(void *arg) {
+    struct timespec delay = {0, 20 * 1000000L};
+    nanosleep(&delay, NULL);
+    remove_agent_now(*(AgentID *)arg);
+    return NULL;
+}
+
+void test_wait_events_wakes_once_per_empty_queue(void) {
+    patika_destroy(ctx);
+    PatikaConfig config = {
+        .grid_type = MAP_TYPE_RECTANGULAR,
+        .max_agents = 100,
+        .max_barracks = 10,
+        .grid_width = 16,
+        .grid_height = 16,
+        .command_queue_size = 64,
+        .event_queue_size = 64,
+        .rng_seed = 7,
+        .event_notify_fd = 1
+    };
+    ctx = patika_create(&config);
+    TEST_ASSERT_NOT_NULL(ctx);
+
+    AgentID ids[3];
+    for (int i = 0; i < 3; i++) {
+        ids[i] = spawn_agent_at(i, 0);
+    }
+    PatikaEvent events[8];
+    TEST_ASSERT_EQUAL(0, patika_poll_events(ctx, events, 8));
+    TEST_ASSERT_EQUAL(PATIKA_ERR_TIMEOUT, patika_wait_events(ctx, 5));
+    TEST_ASSERT_EQUAL_UINT64(0, patika_get_stats(ctx).event_wakeups);
+
+    // parked until the sim thread's tick queues an event
+    pthread_t sim;
+    pthread_create(&sim, NULL, delayed_removal, &ids[0]);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_wait_events(ctx, 5000));
+    pthread_join(sim, NULL);
+    TEST_ASSERT_EQUAL_UINT64(1, patika_get_stats(ctx).event_wakeups);
+    TEST_ASSERT_EQUAL(1, patika_poll_events(ctx, events, 8));
+
+    // unread events do not signal again
+    remove_agent_now(ids[1]);
+    remove_agent_now(ids[2]);
+    TEST_ASSERT_EQUAL_UINT64(2, patika_get_stats(ctx).event_wakeups);
+    TEST_ASSERT_EQUAL(PATIKA_OK, patika_wait_events(ctx, 0));
+
+#ifdef __linux__
+    int fd = patika_get_event_fd(ctx);
+    TEST_ASSERT_TRUE(fd >= 0);
+    struct pollfd pfd = {fd, POLLIN, 0};
+    TEST_ASSERT_EQUAL(1, poll(&pfd, 1, 0));
+    uint64_t signals = 0;
+    TEST_ASSERT_EQUAL(sizeof(signals), read(fd, &signals, sizeof(signals)));
+    TEST_ASSERT_EQUAL_UINT64(2, signals);
+    TEST_ASSERT_EQUAL(0, poll(&pfd, 1, 0));
+#endif
+    TEST_ASSERT_EQUAL(2, patika_poll_events(ctx, events, 8));
+}
+
+typedef struct {
+    _Atomic int done;
+    uint32_t reads;
+    uint32_t torn;
+} SnapshotReaderArgs;
+
+static uint64_t snapshot_checksum(const PatikaSnapshot *snap) {
+    uint64_t sum = snap->version * 31u + snap->agent_count;
+    for (uint32_t i = 0; i < snap->agent_count; i++) {
+        sum = sum * 131u + (uint64_t)snap->agents[i].id;
+        sum = sum * 131u + (uint64_t)(uint32_t)snap->agents[i].pos_q;
+        sum = sum * 131u + (uint64_t)(uint32_t)snap->agents[i].pos_r;
+    }
+    return sum;
+}
+
+static void *slow_snapshot_reader(void *arg) {
+    SnapshotReaderArgs *args = (SnapshotReaderArgs *)arg;
+    struct timespec delay = {0, 500000L};
+    while (!atomic_load(&args->done)) {
+        const PatikaSnapshot *snap = patika_acquire_snapshot(ctx);
+        uint64_t before = snapshot_checksum(snap);
+        nanosleep(&delay, NULL); // spans several ticks
+        if (snapshot_checksum(snap) != before) {
+            args->torn++;
+        }
+        patika_release_snapshot(ctx, snap);
+        args->reads++;
+    }
+    return NULL;
+}
+
+void test_pinned_snapshot_survives_ticks(void) {
+    AgentID ids[32];
+    for (int i = 0; i < 32; i++) {
+        ids[i] = spawn_agent_at(i, 0);
+    }
+
+    SnapshotReaderArgs args = {0};
+    pthread_t reader;
+    pthread_create(&reader, NULL, slow_snapshot_reader, &args);
+
+    struct timespec pause = {0, 50000L};
+    for (int t = 0; t < 400; t++) {
+        if (t % 40 == 0) {
+            for (int i = 0; i < 32; i++) {
+                PatikaCommand cmd = {0};
+                cmd.type = CMD_SET_GOAL;
+                cmd.set_goal.agent_id = ids[i];
+                cmd.set_goal.goal_q = i;
+                cmd.set_goal.goal_r = (t / 40) % 2 ? 0 : 30;
+                TEST_ASSERT_EQUAL(PATIKA_OK, patika_submit_command(ctx, &cmd));
+            }
+        }
+        patika_tick(ctx);
+        nanosleep(&pause, NULL);
+    }
+    atomic_store(&args.done, 1);
+    pthread_join(reader, NULL);
+
+    TEST_ASSERT_TRUE(args.reads > 0);
+    TEST_ASSERT_EQUAL(0, args.torn);
+    // one reader never pins more than one spare buffer
+    TEST_ASSERT_EQUAL_UINT64(0, patika_get_stats(ctx).snapshots_skipped);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_pooled_payloads_from_producer_threads);
+    RUN_TEST(test_oversize_pooled_payload);
+    RUN_TEST(test_submit_batch_modes);
+    RUN_TEST(test_submit_batch_from_producer_threads);
+    RUN_TEST(test_producer_lanes_drain_in_lane_order);
+    RUN_TEST(test_full_lane_only_rejects_its_producer);
+    RUN_TEST(test_tick_limit_is_shared_fairly_with_lanes);
+    RUN_TEST(test_submit_wait_parks_until_drained);
+    RUN_TEST(test_blocking_broadcast_waits_for_slowest_subscriber);
+    RUN_TEST(test_wait_events_wakes_once_per_empty_queue);
+    RUN_TEST(test_pinned_snapshot_survives_ticks);
+
+    return UNITY_END();
+}